@@ -3,6 +3,7 @@
 
 #include "AbilitySystem/Abilities/HeroesGameplayAbilityBase.h"
 
+#include "AbilitySystem/Auxiliary/ProjectileExtensionComponent.h"
 #include "AbilitySystem/Components/HeroesAbilitySystemComponent.h"
 #include "Characters/HeroesCharacterBase.h"
 
@@ -26,6 +27,43 @@ AHeroesCharacterBase* UHeroesGameplayAbilityBase::GetCharacterFromActorInfo() co
 	return nullptr;
 }
 
+AActor* UHeroesGameplayAbilityBase::SpawnPredictedProjectile(TSubclassOf<AActor> ProjectileClass, const FTransform& SpawnTransform)
+{
+	AActor* AvatarActor = CurrentActorInfo ? GetAvatarActorFromActorInfo() : nullptr;
+	if (!ProjectileClass || !AvatarActor)
+	{
+		return nullptr;
+	}
+
+	// Only the server and the client predicting this ability spawn the projectile.
+	const FPredictionKey PredictionKey = GetCurrentActivationInfo().GetActivationPredictionKey();
+	const bool bIsPredictedProjectile = !CurrentActorInfo->IsNetAuthority();
+	if (bIsPredictedProjectile && !PredictionKey.IsLocalClientKey())
+	{
+		return nullptr;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Owner = AvatarActor;
+	SpawnParams.Instigator = Cast<APawn>(AvatarActor);
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	AActor* SpawnedProjectile = AvatarActor->GetWorld()->SpawnActor<AActor>(ProjectileClass, SpawnTransform, SpawnParams);
+	if (!SpawnedProjectile)
+	{
+		return nullptr;
+	}
+
+	/* Projectile components added in blueprints only exist once the projectile has finished spawning. The server's
+	 * projectile doesn't replicate until the end of the frame, so its prediction key still arrives with it. */
+	if (UProjectileExtensionComponent* ProjectileComponent = SpawnedProjectile->FindComponentByClass<UProjectileExtensionComponent>())
+	{
+		ProjectileComponent->InitPrediction(PredictionKey, bIsPredictedProjectile);
+	}
+
+	return SpawnedProjectile;
+}
+
 void UHeroesGameplayAbilityBase::OnInputReleased()
 {}
 
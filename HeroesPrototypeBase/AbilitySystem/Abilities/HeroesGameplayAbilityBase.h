@@ -52,6 +52,22 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Heroes|AbilitySystem|Abilities")
 	AHeroesCharacterBase* GetCharacterFromActorInfo() const;
 
+	/**
+	 * Spawns a projectile that is predicted by the client activating this ability. The server spawns the real,
+	 * replicated projectile, and the predicting client spawns a cosmetic copy of it immediately. When the server's
+	 * projectile reaches the predicting client, it replaces the cosmetic projectile without re-spawning it. Other
+	 * clients don't spawn anything and only receive the server's projectile.
+	 *
+	 * Projectiles spawned this way should use a UProjectileExtensionComponent. Otherwise, the cosmetic projectile is
+	 * never replaced.
+	 *
+	 * @param ProjectileClass	The projectile actor to spawn.
+	 * @param SpawnTransform	Where to spawn the projectile.
+	 * @return					The spawned projectile. Null on clients that aren't predicting this ability.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Heroes|AbilitySystem|Abilities", meta = (DeterminesOutputType = "ProjectileClass"))
+	AActor* SpawnPredictedProjectile(TSubclassOf<AActor> ProjectileClass, const FTransform& SpawnTransform);
+
 
 
 	// Ability handler functions.
@@ -0,0 +1,93 @@
+// Copyright Samuel Reitich 2024.
+
+
+#include "AbilitySystem/Auxiliary/HeroesShotTelemetry.h"
+
+#if HEROES_SHOT_TELEMETRY
+
+#include "HeroesLogChannels.h"
+
+#include <atomic>
+
+/**
+ * A single record in the telemetry buffer. Its sequence is odd while its record is being written and even once the
+ * record is complete, so readers can detect records that were overwritten while they were being read.
+ */
+struct FHeroesShotTelemetrySlot
+{
+	std::atomic<uint64> Sequence { 0 };
+
+	FHeroesShotTelemetryRecord Record;
+};
+
+static FHeroesShotTelemetrySlot ShotTelemetrySlots[FHeroesShotTelemetry::Capacity];
+
+/** The total number of shots recorded. The next shot is written to this index, wrapped by the buffer's capacity. */
+static std::atomic<uint64> NumShotsRecorded { 0 };
+
+void FHeroesShotTelemetry::RecordShot(const FHeroesShotTelemetryRecord& Record)
+{
+	const uint64 Index = NumShotsRecorded.fetch_add(1, std::memory_order_relaxed);
+	FHeroesShotTelemetrySlot& Slot = ShotTelemetrySlots[Index % Capacity];
+
+	Slot.Sequence.store(Index * 2 + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	Slot.Record = Record;
+
+	Slot.Sequence.store(Index * 2 + 2, std::memory_order_release);
+}
+
+void FHeroesShotTelemetry::GetRecentShots(TArray<FHeroesShotTelemetryRecord>& OutRecords, int32 MaxRecords)
+{
+	const uint64 End = NumShotsRecorded.load(std::memory_order_acquire);
+	const uint64 Count = FMath::Min<uint64>(FMath::Min<uint64>(End, Capacity), (uint64)FMath::Max(MaxRecords, 0));
+
+	OutRecords.Reset(Count);
+
+	for (uint64 Index = End - Count; Index < End; ++Index)
+	{
+		const FHeroesShotTelemetrySlot& Slot = ShotTelemetrySlots[Index % Capacity];
+
+		// Skip records that are still being written, or that have been overwritten by a newer shot.
+		const uint64 SequenceBefore = Slot.Sequence.load(std::memory_order_acquire);
+		if (SequenceBefore != Index * 2 + 2)
+		{
+			continue;
+		}
+
+		const FHeroesShotTelemetryRecord Record = Slot.Record;
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (Slot.Sequence.load(std::memory_order_relaxed) == SequenceBefore)
+		{
+			OutRecords.Add(Record);
+		}
+	}
+}
+
+static void DumpShotTelemetry(const TArray<FString>& Args)
+{
+	const int32 MaxRecords = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : (int32)FHeroesShotTelemetry::Capacity;
+
+	TArray<FHeroesShotTelemetryRecord> Records;
+	FHeroesShotTelemetry::GetRecentShots(Records, MaxRecords);
+
+	UE_LOG(LogHeroes, Log, TEXT("Shot telemetry (%d shots):"), Records.Num());
+	UE_LOG(LogHeroes, Log, TEXT("ShotTime,Latency,Authority,ShotIndex,SpreadSeed,WeaponHeat,SpreadX,SpreadY,Pellets,Hits"));
+
+	for (const FHeroesShotTelemetryRecord& Record : Records)
+	{
+		UE_LOG(LogHeroes, Log, TEXT("%.4f,%.4f,%d,%d,%d,%.3f,%.3f,%.3f,%d,%d"), Record.ShotTime, Record.Latency, Record.bAuthority ? 1 : 0, Record.ShotIndex, Record.SpreadSeed, Record.WeaponHeat, Record.SpreadX, Record.SpreadY, Record.NumPellets, Record.NumHits);
+	}
+}
+
+static FAutoConsoleCommand DumpShotTelemetryCommand
+(
+	TEXT("Heroes.Weapons.DumpShotTelemetry"),
+	TEXT("Logs the most recently recorded shots as CSV. Optionally takes the maximum number of shots to log."),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&DumpShotTelemetry),
+	ECVF_Default
+);
+
+#endif // HEROES_SHOT_TELEMETRY
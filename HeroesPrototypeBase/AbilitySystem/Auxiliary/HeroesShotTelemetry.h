@@ -0,0 +1,65 @@
+// Copyright Samuel Reitich 2024.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Whether shot telemetry is recorded. Compiled out by default; enable it in this module's build rules to collect
+ * balancing data. */
+#ifndef HEROES_SHOT_TELEMETRY
+#define HEROES_SHOT_TELEMETRY 0
+#endif
+
+#if HEROES_SHOT_TELEMETRY
+
+/**
+ * The telemetry recorded for a single shot of a hit-scan weapon.
+ */
+struct FHeroesShotTelemetryRecord
+{
+	/** The server world time at which the shot was fired. */
+	double ShotTime = 0.0;
+
+	/** The time, in seconds, between the shot being fired and its target data being produced or received on the machine
+	 * that recorded it. */
+	float Latency = 0.0f;
+
+	float WeaponHeat = 0.0f;
+
+	/** The shot's horizontal and vertical spread, in degrees. */
+	float SpreadX = 0.0f;
+	float SpreadY = 0.0f;
+
+	int32 SpreadSeed = 0;
+
+	uint16 ShotIndex = 0;
+
+	uint8 NumPellets = 0;
+
+	/** The number of the shot's hits that hit an actor. */
+	uint8 NumHits = 0;
+
+	/** Whether the shot was recorded by the server. */
+	bool bAuthority = false;
+};
+
+/**
+ * A fixed-size, lock-free ring buffer of recent shot telemetry. Recording a shot is a copy into the buffer; records are
+ * only formatted when they're dumped with the "Heroes.Weapons.DumpShotTelemetry" console command.
+ */
+class HEROESPROTOTYPEBASE_API FHeroesShotTelemetry
+{
+public:
+
+	/** The number of recent shots kept. Older shots are overwritten. */
+	static constexpr uint32 Capacity = 1024;
+
+	/** Records the given shot, overwriting the oldest shot if the buffer is full. Safe to call from any thread. */
+	static void RecordShot(const FHeroesShotTelemetryRecord& Record);
+
+	/** Copies up to the given number of the most recently recorded shots, oldest first. Shots being written while they're
+	 * read are skipped. */
+	static void GetRecentShots(TArray<FHeroesShotTelemetryRecord>& OutRecords, int32 MaxRecords = (int32)Capacity);
+};
+
+#endif // HEROES_SHOT_TELEMETRY
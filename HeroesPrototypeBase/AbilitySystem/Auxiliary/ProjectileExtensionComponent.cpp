@@ -8,10 +8,26 @@
 #include "HeroesLogChannels.h"
 #include "Components/ShapeComponent.h"
 #include "HeroesGameFramework/HeroesGameplayStatics.h"
+#include "HeroesGameFramework/HeroesProjectileSubsystem.h"
+#include "Net/UnrealNetwork.h"
+#include "WorldCollision.h"
 
 UProjectileExtensionComponent::UProjectileExtensionComponent(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
+	// Only the prediction key is replicated; movement is replicated by the projectile actor.
+	SetIsReplicatedByDefault(true);
+
+	// Area-of-effect projectiles only target characters by default.
+	TargetingObjectTypes.Add(UEngineTypes::ConvertToObjectType(ECC_Pawn));
+}
+
+void UProjectileExtensionComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// Prediction keys only serialize to the connection that created them, so other clients receive an invalid key.
+	DOREPLIFETIME_CONDITION(UProjectileExtensionComponent, PredictionKey, COND_InitialOnly);
 }
 
 void UProjectileExtensionComponent::BeginPlay()
@@ -59,6 +75,12 @@ void UProjectileExtensionComponent::BeginPlay()
 		{
 			UE_LOG(LogTemp, Error, TEXT("UProjectileExtensionComponent: Projectile [%s] uses a volume for targeting, but does not have a collision volume that is not the projectile collision component."), *GetNameSafe(Projectile->GetClass()));
 		}
+		else
+		{
+			// The volume doesn't need to track overlaps while the projectile travels; it's only queried once on activation.
+			TargetingVolume->SetGenerateOverlapEvents(false);
+			TargetingVolume->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		}
 	}
 
 	// If this projectile activates with a timer, start the timer when it is spawned.
@@ -78,6 +100,226 @@ void UProjectileExtensionComponent::BeginPlay()
 	}
 
 	Super::BeginPlay();
+
+	// Let the projectile subsystem simulate this projectile's movement with every other projectile's, if it can.
+	if (CanUseBatchedSimulation())
+	{
+		UHeroesProjectileSubsystem* ProjectileSubsystem = GetWorld()->GetSubsystem<UHeroesProjectileSubsystem>();
+		bUsingBatchedSimulation = ProjectileSubsystem && ProjectileSubsystem->RegisterProjectile(this);
+		if (bUsingBatchedSimulation)
+		{
+			SetComponentTickEnabled(false);
+		}
+	}
+
+	/* Predicted projectiles wait to be adopted by the server's projectile. The server's projectile only has a valid
+	 * prediction key on the client that predicted it. */
+	if (UHeroesProjectileSubsystem* ProjectileSubsystem = GetWorld()->GetSubsystem<UHeroesProjectileSubsystem>())
+	{
+		if (bIsPredictedProjectile)
+		{
+			ProjectileSubsystem->RegisterPredictedProjectile(this);
+		}
+		else if (PredictionKey.IsValidKey() && !GetOwner()->HasAuthority())
+		{
+			ProjectileSubsystem->AdoptPredictedProjectile(this);
+		}
+	}
+}
+
+void UProjectileExtensionComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (bUsingBatchedSimulation)
+	{
+		if (UHeroesProjectileSubsystem* ProjectileSubsystem = GetWorld()->GetSubsystem<UHeroesProjectileSubsystem>())
+		{
+			ProjectileSubsystem->UnregisterProjectile(this);
+		}
+
+		bUsingBatchedSimulation = false;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UProjectileExtensionComponent::PullBackHit(FHitResult& Hit, float Distance)
+{
+	const float DesiredTimeBack = FMath::Clamp(0.1f, 0.1f / Distance, 1.0f / Distance) + 0.001f;
+	Hit.Time = FMath::Clamp(Hit.Time - DesiredTimeBack, 0.0f, 1.0f);
+}
+
+bool UProjectileExtensionComponent::CanUseBatchedSimulation() const
+{
+	return ProjectileMovementStyle == EProjectileMovementStyle::Default &&
+		!bIsHomingProjectile &&
+		!bShouldBounce &&
+		!bInterpMovement &&
+		bSimulationEnabled &&
+		IsValid(UpdatedPrimitive);
+}
+
+void UProjectileExtensionComponent::HandleBatchedHit(const FHitResult& Hit, float DeltaTime, const FVector& MoveDelta)
+{
+	// Dispatch the hit the same way a swept move would, so OnProjectileHit is called before the projectile bounces.
+	UpdatedPrimitive->DispatchBlockingHit(*GetOwner(), Hit);
+
+	// The hit may have activated the projectile.
+	if (!IsActive() || !UpdatedComponent)
+	{
+		return;
+	}
+
+	// Stop the projectile. Bouncing projectiles aren't batched, so there's no remaining time in the step to simulate.
+	float SubTickTimeRemaining = DeltaTime * (1.0f - Hit.Time);
+	HandleBlockingHit(Hit, DeltaTime, MoveDelta, SubTickTimeRemaining);
+}
+
+void UProjectileExtensionComponent::InitPrediction(const FPredictionKey& InPredictionKey, bool bInIsPredictedProjectile)
+{
+	PredictionKey = InPredictionKey;
+	bIsPredictedProjectile = bInIsPredictedProjectile;
+
+	// Predicted projectiles are usually initialized after they begin play, so they register themselves here instead.
+	if (bIsPredictedProjectile && HasBegunPlay())
+	{
+		if (UHeroesProjectileSubsystem* ProjectileSubsystem = GetWorld()->GetSubsystem<UHeroesProjectileSubsystem>())
+		{
+			ProjectileSubsystem->RegisterPredictedProjectile(this);
+		}
+	}
+}
+
+void UProjectileExtensionComponent::CatchUpToPrediction(float PredictionDelay)
+{
+	if (PredictionDelay <= 0.0f || !IsActive() || !IsValid(UpdatedPrimitive) || !bSimulationEnabled)
+	{
+		return;
+	}
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ProjectilePredictionCatchUp), false, GetOwner());
+	FCollisionResponseParams ResponseParams;
+	UpdatedPrimitive->InitSweepCollisionParams(QueryParams, ResponseParams);
+	const FCollisionShape CollisionShape = UpdatedPrimitive->GetCollisionShape();
+
+	// Simulate the time missed by the server's projectile in the same sub-steps the projectile would have moved in.
+	float RemainingTime = PredictionDelay;
+	int32 Iterations = 0;
+	while (RemainingTime >= MIN_TICK_TIME && Iterations < MaxSimulationIterations)
+	{
+		Iterations++;
+		const float TimeStep = GetSimulationTimeStep(RemainingTime, Iterations);
+		RemainingTime -= TimeStep;
+
+		const FVector OldVelocity = Velocity;
+		const FVector MoveDelta = ComputeMoveDelta(OldVelocity, TimeStep);
+		Velocity = ComputeVelocity(OldVelocity, TimeStep);
+
+		FQuat NewRotation = UpdatedComponent->GetComponentQuat();
+		if (bRotationFollowsVelocity && !Velocity.IsNearlyZero())
+		{
+			FRotator DesiredRotation = Velocity.Rotation();
+			if (bRotationRemainsVertical)
+			{
+				DesiredRotation.Pitch = 0.0f;
+				DesiredRotation.Roll = 0.0f;
+			}
+
+			NewRotation = DesiredRotation.Quaternion();
+		}
+
+		/* Hits aren't dispatched while catching up, so the projectile doesn't bounce or activate from a position it was
+		 * never seen at. Instead, it stops short of the surface, and hits it on its next update. */
+		const FVector Start = UpdatedComponent->GetComponentLocation();
+		FHitResult Hit;
+		if (GetWorld()->SweepSingleByChannel(Hit, Start, Start + MoveDelta, NewRotation, UpdatedPrimitive->GetCollisionObjectType(), CollisionShape, QueryParams, ResponseParams))
+		{
+			PullBackHit(Hit, MoveDelta.Size());
+			UpdatedComponent->SetWorldLocationAndRotation(Start + MoveDelta * Hit.Time, NewRotation, false, nullptr, ETeleportType::TeleportPhysics);
+			Velocity = OldVelocity;
+			break;
+		}
+
+		UpdatedComponent->SetWorldLocationAndRotation(Start + MoveDelta, NewRotation, false, nullptr, ETeleportType::TeleportPhysics);
+	}
+
+	UpdateComponentVelocity();
+}
+
+bool UProjectileExtensionComponent::StartPredictionCorrection(const UProjectileExtensionComponent* PredictedProjectile)
+{
+	if (!UpdatedComponent || !PredictedProjectile || !PredictedProjectile->UpdatedComponent)
+	{
+		return false;
+	}
+
+	const FVector Offset = PredictedProjectile->UpdatedComponent->GetComponentLocation() - UpdatedComponent->GetComponentLocation();
+	if (PredictionCorrectionDuration <= 0.0f || Offset.IsNearlyZero() || Offset.SizeSquared() > FMath::Square(MaxPredictionCorrectionDistance))
+	{
+		return false;
+	}
+
+	// Only the projectile's visuals are offset. Its collision stays with the server's projectile.
+	CorrectedComponents.Reset();
+	for (USceneComponent* Child : UpdatedComponent->GetAttachChildren())
+	{
+		if (IsValid(Child) && !Child->IsA<UShapeComponent>())
+		{
+			CorrectedComponents.Emplace(Child, Child->GetRelativeLocation());
+		}
+	}
+
+	if (CorrectedComponents.Num() == 0)
+	{
+		return false;
+	}
+
+	PredictionCorrectionOffset = Offset;
+	PredictionCorrectionTimeRemaining = PredictionCorrectionDuration;
+	UpdatePredictionCorrection(0.0f);
+
+	return true;
+}
+
+bool UProjectileExtensionComponent::UpdatePredictionCorrection(float DeltaTime)
+{
+	PredictionCorrectionTimeRemaining = FMath::Max(PredictionCorrectionTimeRemaining - DeltaTime, 0.0f);
+	const float Alpha = PredictionCorrectionDuration > 0.0f ? PredictionCorrectionTimeRemaining / PredictionCorrectionDuration : 0.0f;
+
+	// The offset is in world space, so it's converted into the root's space on every update in case the projectile rotated.
+	const FVector RelativeOffset = UpdatedComponent ? UpdatedComponent->GetComponentTransform().InverseTransformVector(PredictionCorrectionOffset * Alpha) : FVector::ZeroVector;
+	for (const TPair<TWeakObjectPtr<USceneComponent>, FVector>& CorrectedComponent : CorrectedComponents)
+	{
+		if (USceneComponent* Component = CorrectedComponent.Key.Get())
+		{
+			Component->SetRelativeLocation(CorrectedComponent.Value + RelativeOffset);
+		}
+	}
+
+	if (PredictionCorrectionTimeRemaining <= 0.0f)
+	{
+		CorrectedComponents.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+/** Returns the bit representing the given team alignment in a team alignment mask. */
+static uint8 GetTeamAlignmentBit(ERelativeTeamAlignment Alignment)
+{
+	return 1 << static_cast<uint8>(Alignment);
+}
+
+/** Returns a bit mask of the given team alignments, so alignments can be tested without searching an array. */
+static uint8 MakeTeamAlignmentMask(const TArray<ERelativeTeamAlignment>& Alignments)
+{
+	uint8 Mask = 0;
+	for (const ERelativeTeamAlignment Alignment : Alignments)
+	{
+		Mask |= GetTeamAlignmentBit(Alignment);
+	}
+
+	return Mask;
 }
 
 void UProjectileExtensionComponent::OnProjectileHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
@@ -171,6 +413,16 @@ void UProjectileExtensionComponent::OnMovementStopped(const FHitResult& ImpactRe
 
 void UProjectileExtensionComponent::ActivateProjectile(const FHitResult& Hit)
 {
+	/* Predicted projectiles never activate. They stop where they would have activated and wait to be replaced by the
+	 * server's projectile, which activates on its own. */
+	if (bIsPredictedProjectile)
+	{
+		ProjectileCollisionComponent->OnComponentHit.RemoveAll(this);
+		StopMovementImmediately();
+		Deactivate();
+		return;
+	}
+
 	// Mark this projectile as "activated" so it can't be activated again.
 	bProjectileIsActive = true;
 
@@ -191,42 +443,46 @@ void UProjectileExtensionComponent::ActivateProjectile(const FHitResult& Hit)
 		}
 	}
 	// If the projectile targets actors within a defined volume, pass in all valid actors inside that volume as targets.
-	else if (ProjectileTargetingMethod == EProjectileTargetingMethod::InVolumeWithLOS ||
-		ProjectileTargetingMethod == EProjectileTargetingMethod::InVolumeWithoutLOS)
+	else if ((ProjectileTargetingMethod == EProjectileTargetingMethod::InVolumeWithLOS ||
+		ProjectileTargetingMethod == EProjectileTargetingMethod::InVolumeWithoutLOS) &&
+		TargetingVolume && TargetingObjectTypes.Num() > 0)
 	{
-		// Retrieve all actors within the projectile's defined effective volume.
+		// Retrieve all actors within the projectile's defined effective volume with a single overlap query.
+		TArray<FOverlapResult> Overlaps;
+		const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ProjectileTargeting), false, Projectile);
+		GetWorld()->OverlapMultiByObjectType(Overlaps, TargetingVolume->GetComponentLocation(), TargetingVolume->GetComponentQuat(), FCollisionObjectQueryParams(TargetingObjectTypes), TargetingVolume->GetCollisionShape(), QueryParams);
+
+		// Actors can overlap the volume with multiple components.
 		TArray<AActor*> OverlappingActors;
-		TargetingVolume->GetOverlappingActors(OverlappingActors);
+		for (const FOverlapResult& Overlap : Overlaps)
+		{
+			OverlappingActors.AddUnique(Overlap.GetActor());
+		}
+
+		OverlappingActors.RemoveAll([this](const AActor* OverlappingActor)
+		{
+			return !IsValid(OverlappingActor) || OverlappingActor == Projectile;
+		});
 
-		for (AActor* OverlappingActor : OverlappingActors)
+		// If we don't need line-of-sight, add each actor to the list of targets.
+		if (ProjectileTargetingMethod == EProjectileTargetingMethod::InVolumeWithoutLOS)
+		{
+			Targets = MoveTemp(OverlappingActors);
+		}
+		// If we need line-of-sight, test LoS to every actor at once before adding them to the list of targets.
+		else if (ProjectileTargetingMethod == EProjectileTargetingMethod::InVolumeWithLOS)
 		{
-			if (IsValid(OverlappingActor) && OverlappingActor != Projectile)
+			TArray<bool> CanReach;
+			UHeroesGameplayStatics::CanReachTargets(GetWorld(), Projectile->GetActorLocation(), OverlappingActors, TArray<AActor*>(), CanReach);
+
+			for (int32 i = 0; i < OverlappingActors.Num(); ++i)
 			{
-				// If we don't need line-of-sight, add each actor to the list of targets.
-				if (ProjectileTargetingMethod == EProjectileTargetingMethod::InVolumeWithoutLOS)
-				{
-					Targets.Add(OverlappingActor);
-				}
-				// If we need line-of-sight, test LoS to each actor before adding it to the list of targets.
-				else if (ProjectileTargetingMethod == EProjectileTargetingMethod::InVolumeWithLOS)
+				if (CanReach[i])
 				{
-					UE_LOG(LogHeroes, Warning, TEXT("Testing for LoS: [%s]"), *GetNameSafe(OverlappingActor));
-					const TArray<AActor*> ActorsToIgnore = TArray<AActor*>();
-					if (UHeroesGameplayStatics::CanReachTarget(GetWorld(), Projectile->GetActorLocation(), OverlappingActor, ActorsToIgnore))
-					{
-						Targets.Add(OverlappingActor);
-						UE_LOG(LogHeroes, Warning, TEXT("LoS success: [%s]"), *GetNameSafe(OverlappingActor));
-					}
-					else
-					{
-						UE_LOG(LogHeroes, Warning, TEXT("LoS fail: [%s]"), *GetNameSafe(OverlappingActor));
-					}
+					Targets.Add(OverlappingActors[i]);
 				}
 			}
 		}
-
-		// Deactivate the targeting volume to stop registering overlaps.
-		TargetingVolume->Deactivate();
 	}
 
 	// Call any custom activation logic.
@@ -239,10 +495,46 @@ void UProjectileExtensionComponent::ActivateProjectile(const FHitResult& Hit)
 
 void UProjectileExtensionComponent::OnProjectileActivation_Internal(const FHitResult& Hit, TArray<AActor*> Targets)
 {
-	const UAbilitySystemComponent* OwnerASC = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Projectile->GetInstigator());
-	if (!OwnerASC && ActivationEffects.Num() > 0)
+	UAbilitySystemComponent* OwnerASC = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Projectile->GetInstigator());
+	if (!OwnerASC)
+	{
+		if (ActivationEffects.Num() > 0)
+		{
+			UE_LOG(LogHeroes, Error, TEXT("UProjectileExtensionComponent: Owner [%s] does not have an ASC. Effects cannot be applied."), *GetNameSafe(Projectile.Get()));
+		}
+
+		return;
+	}
+
+	// Build each effect's spec once, with a shared context, so it can be applied to every target it affects.
+	const FGameplayEffectContextHandle EffectContextHandle = OwnerASC->MakeEffectContext();
+	TArray<TPair<uint8, FGameplayEffectSpecHandle>, TInlineAllocator<8>> EffectSpecs;
+
+	for (const FTargetedEffects& TargetedEffect : ActivationEffects)
+	{
+		const uint8 TargetMask = MakeTeamAlignmentMask(TargetedEffect.Targets);
+		if (TargetMask == 0)
+		{
+			continue;
+		}
+
+		for (const TSubclassOf<UGameplayEffect>& GameplayEffect : TargetedEffect.Effects)
+		{
+			if (!GameplayEffect.Get())
+			{
+				continue;
+			}
+
+			FGameplayEffectSpecHandle EffectSpecHandle = OwnerASC->MakeOutgoingSpec(GameplayEffect, 1, EffectContextHandle);
+			if (EffectSpecHandle.IsValid())
+			{
+				EffectSpecs.Emplace(TargetMask, MoveTemp(EffectSpecHandle));
+			}
+		}
+	}
+
+	if (EffectSpecs.Num() == 0)
 	{
-		UE_LOG(LogHeroes, Error, TEXT("UProjectileExtensionComponent: Owner [%s] does not have an ASC. Effects cannot be applied."), *GetNameSafe(Projectile.Get()));
 		return;
 	}
 
@@ -250,25 +542,14 @@ void UProjectileExtensionComponent::OnProjectileActivation_Internal(const FHitRe
 	{
 		if (UAbilitySystemComponent* TargetASC = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Target))
 		{
-			for (FTargetedEffects TargetedEffect : ActivationEffects)
+			// TODO: Check this against the hit actor's team alignment instead of just the Enemy enum.
+			const uint8 TargetAlignment = GetTeamAlignmentBit(ERelativeTeamAlignment::Enemy);
+
+			for (const TPair<uint8, FGameplayEffectSpecHandle>& EffectSpec : EffectSpecs)
 			{
-				// TODO: Check this against the hit actor's team alignment instead of just the Enemy enum.
-				if (TargetedEffect.Targets.Contains(ERelativeTeamAlignment::Enemy))
+				if (EffectSpec.Key & TargetAlignment)
 				{
-					const FGameplayEffectContextHandle EffectContextHandle = OwnerASC->MakeEffectContext();
-					for (TSubclassOf<UGameplayEffect> GameplayEffect : TargetedEffect.Effects)
-					{
-						if (!GameplayEffect.Get())
-						{
-							continue;
-						}
-
-						FGameplayEffectSpecHandle EffectSpecHandle = OwnerASC->MakeOutgoingSpec(GameplayEffect, 1, EffectContextHandle);
-						if (EffectSpecHandle.IsValid())
-						{
-							TargetASC->ApplyGameplayEffectSpecToSelf(*EffectSpecHandle.Data.Get());
-						}
-					}
+					OwnerASC->ApplyGameplayEffectSpecToTarget(*EffectSpec.Value.Data.Get(), TargetASC);
 				}
 			}
 		}
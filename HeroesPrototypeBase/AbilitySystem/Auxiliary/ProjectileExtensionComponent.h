@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "GameplayPrediction.h"
 #include "GameFramework/ProjectileMovementComponent.h"
 #include "ProjectileExtensionComponent.generated.h"
 
@@ -122,6 +123,9 @@ public:
 	/** Default constructor. */
 	UProjectileExtensionComponent(const FObjectInitializer& ObjectInitializer);
 
+	/** Replicates the prediction key this projectile was spawned with. */
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 
 
 	// Initialization.
@@ -132,6 +136,102 @@ public:
 	 * are initialized. */
 	virtual void BeginPlay() override;
 
+	/** Stops this projectile's batched simulation, if it's using it. */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+
+
+	// Batched simulation.
+
+public:
+
+	/** Resolves a blocking hit found by the projectile subsystem's batched simulation. Dispatches the hit to the
+	 * projectile's collision component and then stops the projectile, the same way it would if it had hit something
+	 * while moving itself. */
+	void HandleBatchedHit(const FHitResult& Hit, float DeltaTime, const FVector& MoveDelta);
+
+	/** Moves a blocking hit's time back slightly from the surface it hit, the same way swept component movement does,
+	 * so the projectile doesn't start its next sweep touching the surface. */
+	static void PullBackHit(FHitResult& Hit, float Distance);
+
+protected:
+
+	/** Whether this projectile's movement is simple enough to be simulated by the projectile subsystem. Projectiles
+	 * with player-driven, homing, or bouncing movement tick their own movement, so bounces are resolved with the
+	 * movement component's sub-stepping. */
+	bool CanUseBatchedSimulation() const;
+
+	/** Whether this projectile is being simulated by the projectile subsystem instead of ticking its own movement. */
+	bool bUsingBatchedSimulation = false;
+
+
+
+	// Prediction.
+
+public:
+
+	/**
+	 * Assigns the prediction key of the ability that spawned this projectile. On the server, this must be called in the
+	 * same frame the projectile is spawned, so the key is replicated with the projectile.
+	 *
+	 * @param InPredictionKey			The spawning ability's activation prediction key.
+	 * @param bInIsPredictedProjectile	Whether this is a cosmetic projectile spawned by a predicting client, rather
+	 *									than the server's projectile.
+	 */
+	void InitPrediction(const FPredictionKey& InPredictionKey, bool bInIsPredictedProjectile);
+
+	/** The prediction key of the ability that spawned this projectile. Only valid on the server and on the client that
+	 * predicted this projectile. */
+	const FPredictionKey& GetPredictionKey() const { return PredictionKey; }
+
+	/** Whether this is a cosmetic projectile spawned by a predicting client. Predicted projectiles don't apply effects
+	 * and are replaced by the server's projectile when it arrives. */
+	UFUNCTION(BlueprintPure, Category = "Heroes|Projectiles")
+	bool IsPredictedProjectile() const { return bIsPredictedProjectile; }
+
+	/** Moves this projectile forward by the given time, to catch up to the predicted projectile it's adopting. The
+	 * projectile stops short of anything it would hit, and hits it on its next update instead. */
+	void CatchUpToPrediction(float PredictionDelay);
+
+	/** Starts blending this projectile's visuals from the given predicted projectile's location to this projectile's
+	 * own. Should be called after catching up to the predicted projectile, so only the remaining error is blended.
+	 * Returns false if the projectile should snap to its own location instead. */
+	bool StartPredictionCorrection(const UProjectileExtensionComponent* PredictedProjectile);
+
+	/** Advances this projectile's visual correction. Returns false once the correction has finished. */
+	bool UpdatePredictionCorrection(float DeltaTime);
+
+protected:
+
+	/** How long it takes to blend this projectile's visuals from the location of the predicted projectile it adopts to
+	 * its own location, after catching up to it. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "ProjectilePrediction", meta = (ClampMin = "0.0", Units = "s"))
+	float PredictionCorrectionDuration = 0.25f;
+
+	/** Predicted projectiles farther than this from the server's projectile after it catches up to them (e.g. because
+	 * they hit something that the server's projectile didn't) are snapped to the server's projectile instead of
+	 * blended. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "ProjectilePrediction", meta = (ClampMin = "0.0", Units = "cm"))
+	float MaxPredictionCorrectionDistance = 500.0f;
+
+private:
+
+	/** The prediction key of the ability that spawned this projectile. Only replicated to the client that predicted it. */
+	UPROPERTY(Replicated)
+	FPredictionKey PredictionKey;
+
+	/** Whether this is a cosmetic projectile spawned by a predicting client. */
+	bool bIsPredictedProjectile = false;
+
+	/** The world-space offset from this projectile to the predicted projectile it adopted, when it was adopted. */
+	FVector PredictionCorrectionOffset = FVector::ZeroVector;
+
+	/** The time remaining in this projectile's visual correction. */
+	float PredictionCorrectionTimeRemaining = 0.0f;
+
+	/** The visual components offset by this projectile's correction, and their original relative locations. */
+	TArray<TPair<TWeakObjectPtr<USceneComponent>, FVector>> CorrectedComponents;
+
 
 
 	// Utils.
@@ -193,7 +293,8 @@ protected:
 	void OnProjectileHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
 
 	/** A pointer to the collision component used as the volume for detecting targets. This is only used if the
-	 * targeting method uses a volume. */
+	 * targeting method uses a volume. Only the volume's shape is used: its collision is disabled, and targets inside
+	 * it are found with a single overlap query when the projectile activates. */
 	UPROPERTY(BlueprintReadOnly, Category = "Heroes|Projectiles")
 	TObjectPtr<UShapeComponent> TargetingVolume = nullptr;
 
@@ -252,4 +353,9 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "ProjectileActivation")
 	EProjectileTargetingMethod ProjectileTargetingMethod;
 
+	/** The types of objects that can be targeted by this projectile's targeting volume, if its targeting method uses a
+	 * volume. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "ProjectileActivation", meta = (EditCondition = "ProjectileTargetingMethod == EProjectileTargetingMethod::InVolumeWithLOS || ProjectileTargetingMethod == EProjectileTargetingMethod::InVolumeWithoutLOS"))
+	TArray<TEnumAsByte<EObjectTypeQuery>> TargetingObjectTypes;
+
 };
@@ -7,20 +7,164 @@
 #include "AbilitySystemGlobals.h"
 #include "HeroesLogChannels.h"
 #include "Abilities/GameplayAbility.h"
+#include "AbilitySystem/Auxiliary/HeroesShotTelemetry.h"
+#include "AbilitySystem/HeroesGameplayAbilityTargetTypes.h"
 #include "AbilitySystem/HeroesNativeGameplayTags.h"
+#include "Async/ParallelFor.h"
+#include "Characters/Heroes/HeroBase.h"
 #include "Curves/CurveVector.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/GameStateBase.h"
+#include "HeroesGameFramework/HeroesLagCompensationSubsystem.h"
+#include "HeroesGameFramework/HeroesPhysicalMaterial.h"
+#include "Inventory/InventoryItemDefinition.h"
+#include "Inventory/InventoryItemInstance.h"
 #include "Inventory/ItemTraits/WeaponItemTrait.h"
 #include "Inventory/ItemTraits/WeaponStaticDataAsset.h"
 
-void AHeroesGATA_Trace::Configure(AActor* InSourceActor, FCollisionProfileName InTraceProfile, bool bInIgnoreBlockingHits, bool bInShouldProduceTargetDataOnServer, float InMaxRange, UWeaponItemTrait* InWeaponItemTrait)
+static TAutoConsoleVariable<float> CVarMaxAimError
+(
+	TEXT("Heroes.Weapons.MaxAimError"),
+	5.0f,
+	TEXT("How far, in degrees, a client's shot can deviate from the server's re-simulation of it and still be accepted."),
+	ECVF_Default
+);
+
+static TAutoConsoleVariable<float> CVarMaxHeatErrorSteps
+(
+	TEXT("Heroes.Weapons.MaxHeatErrorSteps"),
+	1.0f,
+	TEXT("How many of its weapon's cooldown steps lower than the server's weapon heat a client's shot can claim its")
+	TEXT(" weapon heat to be and still be accepted, in addition to the heat's quantization error."),
+	ECVF_Default
+);
+
+static TAutoConsoleVariable<bool> CVarParallelPelletTraces
+(
+	TEXT("Heroes.Weapons.ParallelPelletTraces"),
+	true,
+	TEXT("Whether the pellets of multi-pellet shots are traced in parallel."),
+	ECVF_Default
+);
+
+/** Shots with fewer pellets than this are traced serially, since it isn't worth dispatching them to other threads. */
+static constexpr int32 ParallelPelletTraceThreshold = 4;
+
+static TAutoConsoleVariable<bool> CVarAsyncServerTraces
+(
+	TEXT("Heroes.Weapons.AsyncServerTraces"),
+	true,
+	TEXT("Whether target actors configured to use async traces trace asynchronously when producing target data on the")
+	TEXT(" server."),
+	ECVF_Default
+);
+
+/** Async traces' user data stores their shot's ID above this bit, and their pellet's index below it. */
+static constexpr uint32 AsyncShotIdShift = 8;
+static constexpr uint32 AsyncShotIdMask = MAX_uint32 >> AsyncShotIdShift;
+
+DECLARE_CYCLE_STAT(TEXT("Pellet Traces"), STAT_PelletTraces, STATGROUP_Game);
+
+/** Creates a hit result for a trace that didn't hit anything, located at the end of the trace. */
+static FHitResult MakeMissHitResult(const FVector& TraceStart, const FVector& TraceEnd)
+{
+	FHitResult HitResult;
+
+	HitResult.TraceStart = TraceStart;
+	HitResult.TraceEnd = TraceEnd;
+	HitResult.Location = TraceEnd;
+	HitResult.ImpactPoint = TraceEnd;
+
+	return HitResult;
+}
+
+#if HEROES_SHOT_TELEMETRY
+/** Records the shot in the given target data. Only the first shot in the target data is recorded; target actors only
+ * produce one shot at a time. */
+static void RecordShotTelemetry(const FGameplayAbilityTargetDataHandle& Data, const UWorld* World, TFunctionRef<FVector(float)> GetSpreadAtHeat, bool bLatencyFromShotTime)
+{
+	FHeroesShotTelemetryRecord Record;
+	bool bFoundShot = false;
+
+	for (const TSharedPtr<FGameplayAbilityTargetData>& TargetData : Data.Data)
+	{
+		if (!TargetData.IsValid())
+		{
+			continue;
+		}
+
+		const UScriptStruct* DataType = TargetData->GetScriptStruct();
+
+		if (DataType->IsChildOf(FHeroesGameplayAbilityTargetData_PelletHits::StaticStruct()))
+		{
+			const FHeroesGameplayAbilityTargetData_PelletHits* PelletData = static_cast<const FHeroesGameplayAbilityTargetData_PelletHits*>(TargetData.Get());
+			Record.ShotTime = PelletData->ShotTime;
+			Record.ShotIndex = PelletData->ShotIndex;
+			Record.SpreadSeed = PelletData->SpreadSeed;
+			Record.WeaponHeat = PelletData->WeaponHeat;
+			Record.NumPellets = PelletData->NumPellets;
+
+			for (const FHeroesPelletHit& PelletHit : PelletData->Hits)
+			{
+				Record.NumHits += PelletHit.Actor.IsValid() ? 1 : 0;
+			}
+
+			bFoundShot = true;
+		}
+		else if (DataType->IsChildOf(FHeroesGameplayAbilityTargetData_SingleTargetHit::StaticStruct()))
+		{
+			const FHeroesGameplayAbilityTargetData_SingleTargetHit* ShotData = static_cast<const FHeroesGameplayAbilityTargetData_SingleTargetHit*>(TargetData.Get());
+			Record.ShotTime = ShotData->ShotTime;
+			Record.ShotIndex = ShotData->ShotIndex;
+			Record.SpreadSeed = ShotData->SpreadSeed;
+			Record.WeaponHeat = ShotData->WeaponHeat;
+			Record.NumPellets = 1;
+			Record.NumHits += ShotData->HitResult.GetActor() ? 1 : 0;
+
+			bFoundShot = true;
+		}
+	}
+
+	if (!bFoundShot)
+	{
+		return;
+	}
+
+	const AGameStateBase* GameState = World->GetGameState();
+	const double CurrentTime = GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+
+	Record.Latency = bLatencyFromShotTime ? (float)(CurrentTime - Record.ShotTime) : 0.0f;
+	const FVector Spread = GetSpreadAtHeat(Record.WeaponHeat);
+	Record.SpreadX = Spread.X;
+	Record.SpreadY = Spread.Y;
+	Record.bAuthority = World->GetNetMode() != NM_Client;
+
+	FHeroesShotTelemetry::RecordShot(Record);
+}
+#endif // HEROES_SHOT_TELEMETRY
+
+void AHeroesGATA_Trace::Configure(AActor* InSourceActor, FCollisionProfileName InTraceProfile, bool bInIgnoreBlockingHits, bool bInShouldProduceTargetDataOnServer, float InMaxRange, UInventoryItemInstance* InWeaponItem, bool bInUseAsyncTraces)
 {
 	SourceActor = InSourceActor;
 	TraceProfile = InTraceProfile;
 	bIgnoreBlockingHits = bInIgnoreBlockingHits;
 	bShouldProduceTargetDataOnServer = bInShouldProduceTargetDataOnServer;
+	ShouldProduceTargetDataOnServer = bInShouldProduceTargetDataOnServer;
 	MaxRange = InMaxRange;
-	WeaponItemTrait = InWeaponItemTrait;
+	WeaponItem = InWeaponItem;
+
+	// The weapon's definition may not have replicated to clients yet.
+	const UInventoryItemDefinition* WeaponItemDefinition = IsValid(InWeaponItem) ? InWeaponItem->GetItemDefinition() : nullptr;
+	WeaponItemTrait = WeaponItemDefinition ? WeaponItemDefinition->FindTraitByClass<UWeaponItemTrait>() : nullptr;
+
+	bUseAsyncTraces = bInUseAsyncTraces;
 	bDestroyOnConfirmation = false;
+
+	// Build the query parameters once, so they don't have to be rebuilt for every shot.
+	TraceQueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(AHeroesGATA_Trace), false);
+	TraceQueryParams.bReturnPhysicalMaterial = true;
+	TraceQueryParams.AddIgnoredActor(InSourceActor);
+	TraceQueryParams.bIgnoreBlocks = bIgnoreBlockingHits;
 }
 
 void AHeroesGATA_Trace::CancelTargeting()
@@ -32,6 +176,9 @@ void AHeroesGATA_Trace::CancelTargeting()
 		ASC->AbilityReplicatedEventDelegate(EAbilityGenericReplicatedEvent::GenericCancel, OwningAbility->GetCurrentAbilitySpecHandle(), OwningAbility->GetCurrentActivationInfo().GetActivationPredictionKey()).Remove(GenericCancelHandle);
 	}
 
+	// Traces that complete after targeting is cancelled are ignored.
+	PendingAsyncShots.Reset();
+
 	CanceledDelegate.Broadcast(FGameplayAbilityTargetDataHandle());
 }
 
@@ -41,33 +188,357 @@ void AHeroesGATA_Trace::ConfirmTargetingAndContinue()
 
 	if (SourceActor)
 	{
-		TArray<FHitResult> HitResults = PerformTrace(SourceActor);
+		/* Send the shooter's pending movement before their target data, so the server has the aim that this shot was
+		 * fired with by the time it validates the shot. */
+		const ACharacter* Character = Cast<ACharacter>(SourceActor);
+		if (Character && !Character->HasAuthority() && Character->GetCharacterMovement())
+		{
+			Character->GetCharacterMovement()->FlushServerMoves();
+		}
+
+		// Shots are counted per ability activation, so restart the count when the ability is activated again.
+		const FPredictionKey ActivationPredictionKey = OwningAbility ? OwningAbility->GetCurrentActivationInfo().GetActivationPredictionKey() : FPredictionKey();
+		if (!(ActivationPredictionKey == ShotPredictionKey))
+		{
+			ShotPredictionKey = ActivationPredictionKey;
+			NextShotIndex = 0;
+		}
+
+		/* Timestamp the hits so the server can validate them against where their targets were when they were traced. The
+		 * timestamp is quantized the same way it's replicated, so the server re-fires the weapon at exactly this time. */
+		const AGameStateBase* GameState = GetWorld()->GetGameState();
+		const double ShotTime = FHeroesGameplayAbilityTargetData_SingleTargetHit::QuantizeShotTime(GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds());
+
+		/* Derive the shot's spread from state that the server also has, instead of a local random number, so the server
+		 * can reproduce it. The weapon's heat is derived from the timestamps of its shots. */
+		CurrentShotIndex = NextShotIndex++;
+		CurrentSpreadSeed = FHeroesGameplayAbilityTargetData_SingleTargetHit::MakeSpreadSeed(ActivationPredictionKey, CurrentShotIndex);
+		CurrentWeaponHeat = FHeroesGameplayAbilityTargetData_SingleTargetHit::QuantizeWeaponHeat(UWeaponItemTrait::FireWeapon(WeaponItem, ShotTime));
+
 		FGameplayAbilityTargetDataHandle Data;
 
-		for (int32 i = 0; i < HitResults.Num(); i++)
+		// Async shots produce their target data when their traces complete.
+		if (ShouldUseAsyncTraces())
+		{
+			QueueAsyncTraces(SourceActor, ShotTime);
+			return;
+		}
+
+		// Multi-pellet shots pack every pellet's hits into a single target data entry.
+		if (GetPelletCount() > 1)
+		{
+			FHeroesGameplayAbilityTargetData_PelletHits* PelletData = new FHeroesGameplayAbilityTargetData_PelletHits();
+			PelletData->ShotTime = ShotTime;
+			PelletData->ShotIndex = CurrentShotIndex;
+			PelletData->SpreadSeed = CurrentSpreadSeed;
+			PelletData->WeaponHeat = CurrentWeaponHeat;
+			PerformPelletTraces(SourceActor, *PelletData);
+			Data.Add(PelletData);
+		}
+		else
 		{
-			FGameplayAbilityTargetData_SingleTargetHit* ReturnData = new FGameplayAbilityTargetData_SingleTargetHit();
-			ReturnData->HitResult = HitResults[i];
-			Data.Add(ReturnData);
+			TArray<FHitResult> HitResults = PerformTrace(SourceActor);
+			TArray<float, TInlineAllocator<4>> DamageMultipliers;
+			ResolvePenetration(HitResults, DamageMultipliers);
+
+			for (int32 i = 0; i < HitResults.Num(); i++)
+			{
+				Data.Add(new FHeroesGameplayAbilityTargetData_SingleTargetHit(HitResults[i], ShotTime, CurrentShotIndex, CurrentSpreadSeed, CurrentWeaponHeat, DamageMultipliers[i]));
+			}
 		}
 
+#if HEROES_SHOT_TELEMETRY
+		const bool bAiming = IsAiming();
+		RecordShotTelemetry(Data, GetWorld(), [this, bAiming](float WeaponHeat) { return GetSpread(WeaponHeat, bAiming); }, false);
+#endif
+
 		TargetDataReadyDelegate.Broadcast(Data);
 	}
 }
 
-TArray<FHitResult> AHeroesGATA_Trace::PerformTrace(AActor* InSourceActor)
+bool AHeroesGATA_Trace::OnReplicatedTargetDataReceived(FGameplayAbilityTargetDataHandle& Data) const
 {
-	UAbilitySystemComponent* ASC = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(SourceActor);
+	ValidateReplicatedShot(OwningAbility, Data);
+
+	return Super::OnReplicatedTargetDataReceived(Data);
+}
+
+bool AHeroesGATA_Trace::ValidateReplicatedShot(const UGameplayAbility* Ability, FGameplayAbilityTargetDataHandle& Data) const
+{
+	if (Data.Num() == 0)
+	{
+		return true;
+	}
+
+	/* Every listener for the same replicated target data shares its data, so data that's received more than once (e.g.
+	 * by this target actor's task and by a UAbilityTask_ServerWaitTargetData) has already been validated in-place. */
+	if (LastValidatedTargetData.IsValid() && LastValidatedTargetData.Pin() == Data.Data[0])
+	{
+		return bLastValidatedTargetDataAccepted;
+	}
+
+	// Invalid hits are converted into misses instead of rejecting the target data, so the shot still happens.
+	const AActor* Shooter = (Ability && Ability->GetCurrentActorInfo()) ? Ability->GetAvatarActorFromActorInfo() : SourceActor.Get();
+	bool bAllHitsAccepted = ValidateShotSpread(Ability, Data);
+	bAllHitsAccepted &= UHeroesLagCompensationSubsystem::ValidateTargetDataInWorld(GetWorld(), Data, Shooter);
+
+#if HEROES_SHOT_TELEMETRY
+	const bool bAiming = IsAiming();
+	RecordShotTelemetry(Data, GetWorld(), [this, bAiming](float WeaponHeat) { return GetSpread(WeaponHeat, bAiming); }, true);
+#endif
+
+	LastValidatedTargetData = Data.Data[0];
+	bLastValidatedTargetDataAccepted = bAllHitsAccepted;
+
+	return bAllHitsAccepted;
+}
+
+FVector AHeroesGATA_Trace::GetShotDirection(const FRotator& AimRotation, int32 SpreadSeed, float WeaponHeat, bool bAiming) const
+{
+	FVector ShotDirection;
+	GetPelletDirections(AimRotation, SpreadSeed, WeaponHeat, bAiming, MakeArrayView(&ShotDirection, 1));
+
+	return ShotDirection;
+}
+
+void AHeroesGATA_Trace::GetPelletDirections(const FRotator& AimRotation, int32 SpreadSeed, float WeaponHeat, bool bAiming, TArrayView<FVector> OutDirections) const
+{
+	const UWeaponStaticDataAsset* WeaponData = WeaponItemTrait ? WeaponItemTrait->StaticData.Get() : nullptr;
+	if (!WeaponData || !WeaponData->SpreadCurve)
+	{
+		for (FVector& Direction : OutDirections)
+		{
+			Direction = AimRotation.Vector();
+		}
+
+		return;
+	}
+
+	const FVector Spread = GetSpread(WeaponHeat, bAiming);
+	const float SpreadX = FMath::DegreesToRadians(Spread.X);
+	const float SpreadY = FMath::DegreesToRadians(Spread.Y);
+
+	/* Randomize the spread relative to a fixed direction and then rotate it into the aim direction. This keeps the
+	 * spread independent from small differences between the client's and server's aim. */
+	const FRandomStream WeaponRandomStream(SpreadSeed);
+	const FQuat AimQuat = AimRotation.Quaternion();
+
+	for (FVector& Direction : OutDirections)
+	{
+		Direction = AimQuat.RotateVector(WeaponRandomStream.VRandCone(FVector::ForwardVector, SpreadX, SpreadY));
+	}
+}
+
+FVector AHeroesGATA_Trace::GetSpread(float WeaponHeat, bool bAiming) const
+{
+	const UWeaponStaticDataAsset* WeaponData = WeaponItemTrait ? WeaponItemTrait->StaticData.Get() : nullptr;
+	if (!WeaponData || !WeaponData->SpreadCurve)
+	{
+		return FVector::ZeroVector;
+	}
+
+	const FVector Spread = WeaponData->SampleSpread(WeaponHeat);
+	return Spread * (bAiming ? WeaponData->AimingSpreadMultiplier : 1.0f);
+}
+
+int32 AHeroesGATA_Trace::GetPelletCount() const
+{
+	const UWeaponStaticDataAsset* WeaponData = WeaponItemTrait ? WeaponItemTrait->StaticData.Get() : nullptr;
+	return WeaponData ? FMath::Clamp(WeaponData->PelletCount, 1, (int32)MAX_uint8) : 1;
+}
+
+bool AHeroesGATA_Trace::ValidateShotSpread(const UGameplayAbility* Ability, FGameplayAbilityTargetDataHandle& Data) const
+{
+	// The ability's actor info is used instead of this target actor's targeting state, since shots can be validated without targeting (e.g. by UAbilityTask_ServerWaitTargetData).
+	const FGameplayAbilityActorInfo* ActorInfo = Ability ? Ability->GetCurrentActorInfo() : nullptr;
+	const APlayerController* ShooterPC = ActorInfo ? ActorInfo->PlayerController.Get() : nullptr;
+	if (!ShooterPC || !WeaponItemTrait)
+	{
+		return true;
+	}
+
+	const FPredictionKey ActivationPredictionKey = Ability->GetCurrentActivationInfo().GetActivationPredictionKey();
+	if (!(ActivationPredictionKey == ValidatedPredictionKey))
+	{
+		ValidatedPredictionKey = ActivationPredictionKey;
+		LastValidatedShotIndex = INDEX_NONE;
+	}
+
+	const UAbilitySystemComponent* ASC = Ability->GetAbilitySystemComponentFromActorInfo();
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+	const double ServerTime = GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+	const float MaxAimErrorCos = FMath::Cos(FMath::DegreesToRadians(CVarMaxAimError.GetValueOnGameThread()));
+
+	// Heat is quantized to a byte, and clocks that disagree on a step boundary can disagree by a step of cooldown.
+	const float MaxHeatError = (0.5f / 255.0f) + CVarMaxHeatErrorSteps.GetValueOnGameThread() * UWeaponItemTrait::GetWeaponHeatStep(WeaponItem);
+
+	/* The shooter's aim reaches the server with their movement, which can arrive after their shot, so shots are
+	 * validated against every aim the shooter had from when the shot was fired until now, including their current
+	 * aim. */
+	const UHeroesLagCompensationSubsystem* LagCompensationSubsystem = GetWorld()->GetSubsystem<UHeroesLagCompensationSubsystem>();
+	const AHeroBase* Shooter = Cast<AHeroBase>(ShooterPC->GetPawn());
+	TArray<FHeroesAimState, TInlineAllocator<16>> AimStates;
+	auto GatherAimStates = [&](double ShotTime)
+	{
+		AimStates.Reset();
+
+		FHeroesAimState& CurrentAim = AimStates.AddDefaulted_GetRef();
+		CurrentAim.AimRotation = ShooterPC->GetControlRotation();
+		CurrentAim.bAiming = ASC && ASC->HasMatchingGameplayTag(FHeroesNativeGameplayTags::Get().State_Aiming);
+
+		if (LagCompensationSubsystem && Shooter)
+		{
+			LagCompensationSubsystem->GetAimStatesSince(Shooter, ShotTime, AimStates);
+		}
+	};
+
+	bool bAllHitsAccepted = true;
+	int32 HighestShotIndex = LastValidatedShotIndex;
+
+	/* Fire the server's copy of the weapon once for each new shot, at the shot's timestamp, so the server knows the
+	 * weapon's exact heat when the shot was fired. Shots can't claim to have been fired in the future to give the
+	 * weapon more time to cool down. */
+	float ServerShotHeat = 0.0f;
+	auto FireServerShot = [&](uint16 ShotIndex, double ShotTime)
+	{
+		if ((int32)ShotIndex > HighestShotIndex)
+		{
+			ServerShotHeat = FHeroesGameplayAbilityTargetData_SingleTargetHit::QuantizeWeaponHeat(UWeaponItemTrait::FireWeapon(WeaponItem, FMath::Min(ShotTime, ServerTime)));
+		}
+	};
+
+	/* The shot must be new, must use the seed derived from its index, and can't claim a lower heat (and therefore
+	 * less spread) than the server's. */
+	auto IsShotStateValid = [&](uint16 ShotIndex, int32 SpreadSeed, float WeaponHeat)
+	{
+		return (int32)ShotIndex > LastValidatedShotIndex &&
+			SpreadSeed == FHeroesGameplayAbilityTargetData_SingleTargetHit::MakeSpreadSeed(ActivationPredictionKey, ShotIndex) &&
+			WeaponHeat >= ServerShotHeat - MaxHeatError;
+	};
+
+	for (TSharedPtr<FGameplayAbilityTargetData>& TargetData : Data.Data)
+	{
+		if (!TargetData.IsValid())
+		{
+			continue;
+		}
+
+		const UScriptStruct* DataType = TargetData->GetScriptStruct();
+
+		if (DataType->IsChildOf(FHeroesGameplayAbilityTargetData_PelletHits::StaticStruct()))
+		{
+			FHeroesGameplayAbilityTargetData_PelletHits* PelletData = static_cast<FHeroesGameplayAbilityTargetData_PelletHits*>(TargetData.Get());
+			FireServerShot(PelletData->ShotIndex, PelletData->ShotTime);
+			HighestShotIndex = FMath::Max(HighestShotIndex, (int32)PelletData->ShotIndex);
+
+			const bool bShotValid = PelletData->NumPellets == GetPelletCount() && IsShotStateValid(PelletData->ShotIndex, PelletData->SpreadSeed, PelletData->WeaponHeat);
+
+			/* Every pellet is fired from the same aim, so re-simulate the pellets from each of the shooter's aims, and
+			 * accept the pellet hits that match the aim that matches the most of them. */
+			TArray<bool, TInlineAllocator<16>> PelletHitsValid;
+			PelletHitsValid.SetNumZeroed(PelletData->Hits.Num());
+
+			if (bShotValid)
+			{
+				GatherAimStates(PelletData->ShotTime);
+
+				TArray<FVector, TInlineAllocator<16>> ExpectedDirections;
+				ExpectedDirections.SetNumUninitialized(PelletData->NumPellets);
+				TArray<bool, TInlineAllocator<16>> AimPelletHitsValid;
+				AimPelletHitsValid.SetNumUninitialized(PelletData->Hits.Num());
+				int32 BestNumValid = 0;
+
+				for (const FHeroesAimState& Aim : AimStates)
+				{
+					GetPelletDirections(Aim.AimRotation, PelletData->SpreadSeed, PelletData->WeaponHeat, Aim.bAiming, ExpectedDirections);
+
+					// Each pellet hit must be roughly in the direction that its pellet was re-simulated in.
+					int32 NumValid = 0;
+					for (int32 HitIndex = 0; HitIndex < PelletData->Hits.Num(); ++HitIndex)
+					{
+						const FHeroesPelletHit& PelletHit = PelletData->Hits[HitIndex];
+						const FVector ClaimedDirection = (FVector(PelletHit.ImpactPoint) - PelletData->TraceStart).GetSafeNormal();
+						AimPelletHitsValid[HitIndex] = ExpectedDirections.IsValidIndex(PelletHit.PelletIndex) && (ExpectedDirections[PelletHit.PelletIndex] | ClaimedDirection) >= MaxAimErrorCos;
+						NumValid += AimPelletHitsValid[HitIndex] ? 1 : 0;
+					}
+
+					if (NumValid > BestNumValid)
+					{
+						BestNumValid = NumValid;
+						PelletHitsValid = AimPelletHitsValid;
+
+						if (NumValid == PelletData->Hits.Num())
+						{
+							break;
+						}
+					}
+				}
+			}
+
+			for (int32 HitIndex = 0; HitIndex < PelletData->Hits.Num(); ++HitIndex)
+			{
+				FHeroesPelletHit& PelletHit = PelletData->Hits[HitIndex];
+				if (PelletHit.Actor.IsValid() && !PelletHitsValid[HitIndex])
+				{
+					PelletHit.Actor = nullptr;
+					PelletHit.BoneName = NAME_None;
+					bAllHitsAccepted = false;
+				}
+			}
+
+			continue;
+		}
+
+		if (!DataType->IsChildOf(FHeroesGameplayAbilityTargetData_SingleTargetHit::StaticStruct()))
+		{
+			continue;
+		}
+
+		FHeroesGameplayAbilityTargetData_SingleTargetHit* ShotData = static_cast<FHeroesGameplayAbilityTargetData_SingleTargetHit*>(TargetData.Get());
+		FHitResult& Hit = ShotData->HitResult;
+		FireServerShot(ShotData->ShotIndex, ShotData->ShotTime);
+		HighestShotIndex = FMath::Max(HighestShotIndex, (int32)ShotData->ShotIndex);
+
+		if (!Hit.GetActor())
+		{
+			continue;
+		}
+
+		bool bShotValid = IsShotStateValid(ShotData->ShotIndex, ShotData->SpreadSeed, ShotData->WeaponHeat);
+
+		// Re-simulate the shot from each of the shooter's aims, and make sure the client's trace went in roughly the same direction as one of them.
+		if (bShotValid)
+		{
+			GatherAimStates(ShotData->ShotTime);
+
+			const FVector ClaimedDirection = (Hit.TraceEnd - Hit.TraceStart).GetSafeNormal();
+			bShotValid = AimStates.ContainsByPredicate([&](const FHeroesAimState& Aim)
+			{
+				return (GetShotDirection(Aim.AimRotation, ShotData->SpreadSeed, ShotData->WeaponHeat, Aim.bAiming) | ClaimedDirection) >= MaxAimErrorCos;
+			});
+		}
 
-	bool bTraceComplex = false;
-	TArray<AActor*> ActorsToIgnore;
+		if (!bShotValid)
+		{
+			UHeroesLagCompensationSubsystem::ConvertHitToMiss(Hit);
+			bAllHitsAccepted = false;
+		}
+	}
 
-	ActorsToIgnore.Add(InSourceActor);
+	LastValidatedShotIndex = HighestShotIndex;
 
-	FCollisionQueryParams Params(SCENE_QUERY_STAT(AHeroesGATA_Trace), bTraceComplex);
-	Params.bReturnPhysicalMaterial = true;
-	Params.AddIgnoredActors(ActorsToIgnore);
-	Params.bIgnoreBlocks = bIgnoreBlockingHits;
+	return bAllHitsAccepted;
+}
+
+bool AHeroesGATA_Trace::IsAiming() const
+{
+	const UAbilitySystemComponent* ASC = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(SourceActor);
+	return ASC && ASC->HasMatchingGameplayTag(FHeroesNativeGameplayTags::Get().State_Aiming);
+}
+
+TArray<FHitResult> AHeroesGATA_Trace::PerformTrace(AActor* InSourceActor)
+{
+	const FCollisionQueryParams& Params = TraceQueryParams;
 
 	check(PrimaryPC);
 
@@ -75,25 +546,13 @@ TArray<FHitResult> AHeroesGATA_Trace::PerformTrace(AActor* InSourceActor)
 	FRotator ViewRot;
 	PrimaryPC->GetPlayerViewPoint(ViewStart, ViewRot);
 
-	TArray<FHitResult> ReturnHitResults;
-
 	const FVector TraceStart = ViewStart;
 
 	// Randomize the view rotation depending on accuracy
-	FVector ViewDir = ViewRot.Vector();
 	ensure(WeaponItemTrait);
-	UWeaponStaticDataAsset* WeaponData = WeaponItemTrait->StaticData;
-	float CurrentHeat = WeaponItemTrait->CurrentWeaponHeat;
-	FVector Spread = WeaponData->SpreadCurve->GetVectorValue(CurrentHeat);
-	Spread *= ASC && ASC->HasMatchingGameplayTag(FHeroesNativeGameplayTags::Get().State_Aiming) ? WeaponData->AimingSpreadMultiplier : 1.0f;
-	float SpreadX = FMath::DegreesToRadians(Spread.X);
-	float SpreadY = FMath::DegreesToRadians(Spread.Y);
-	const int32 RandomSeed = FMath::Rand();
-	FRandomStream WeaponRandomStream(RandomSeed);
-	const FVector ViewDirWithSpread = WeaponRandomStream.VRandCone(ViewDir, SpreadX, SpreadY);
-
-	UE_LOG(LogHeroes, Warning, TEXT("CurrentHeat: %f, Spread: %f, %f"), CurrentHeat, SpreadX, SpreadY);
-	
+	const FVector ViewDirWithSpread = GetShotDirection(ViewRot, CurrentSpreadSeed, CurrentWeaponHeat, IsAiming());
+
+
 	const FVector TraceEnd = ViewStart + (ViewDirWithSpread * MaxRange);
 	CurrentTraceEnd = TraceEnd;
 
@@ -104,14 +563,277 @@ TArray<FHitResult> AHeroesGATA_Trace::PerformTrace(AActor* InSourceActor)
 
 	if (HitResults.Num() < 1)
 	{
-		FHitResult HitResult;
-
-		HitResult.TraceStart = TraceStart;
-		HitResult.TraceEnd = TraceEnd;
-		HitResult.Location = TraceEnd;
-		HitResult.ImpactPoint = TraceEnd;
-		HitResults.Add(HitResult);
+		HitResults.Add(MakeMissHitResult(TraceStart, TraceEnd));
 	}
 
 	return HitResults;
 }
+
+void AHeroesGATA_Trace::PerformPelletTraces(AActor* InSourceActor, FHeroesGameplayAbilityTargetData_PelletHits& OutPelletData)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PelletTraces);
+
+	const FCollisionQueryParams& Params = TraceQueryParams;
+
+	check(PrimaryPC);
+
+	FVector ViewStart;
+	FRotator ViewRot;
+	PrimaryPC->GetPlayerViewPoint(ViewStart, ViewRot);
+
+	// Generate every pellet's direction in one pass.
+	const int32 NumPellets = GetPelletCount();
+	TArray<FVector, TInlineAllocator<16>> PelletTraceEnds;
+	PelletTraceEnds.SetNumUninitialized(NumPellets);
+	GetPelletDirections(ViewRot, CurrentSpreadSeed, CurrentWeaponHeat, IsAiming(), PelletTraceEnds);
+
+	for (FVector& PelletTraceEnd : PelletTraceEnds)
+	{
+		PelletTraceEnd = ViewStart + (PelletTraceEnd * MaxRange);
+	}
+
+	/* Trace every pellet as a batch. Scene queries are read-only, so the pellets can be traced in parallel; each
+	 * pellet writes only to its own results. */
+	UWorld* World = InSourceActor->GetWorld();
+	TArray<TArray<FHitResult>, TInlineAllocator<16>> PelletHitResults;
+	PelletHitResults.SetNum(NumPellets);
+
+	ParallelFor(NumPellets, [&](int32 PelletIndex)
+	{
+		World->LineTraceMultiByProfile(PelletHitResults[PelletIndex], ViewStart, PelletTraceEnds[PelletIndex], TraceProfile.Name, Params);
+	}, !CVarParallelPelletTraces.GetValueOnGameThread() || NumPellets < ParallelPelletTraceThreshold);
+
+	PackPelletHits(OutPelletData, ViewStart, PelletTraceEnds, PelletHitResults);
+
+	CurrentTraceEnd = ViewStart + (ViewRot.Vector() * MaxRange);
+	SetActorLocationAndRotation(CurrentTraceEnd, SourceActor->GetActorRotation());
+}
+
+void AHeroesGATA_Trace::PackPelletHits(FHeroesGameplayAbilityTargetData_PelletHits& OutPelletData, const FVector& TraceStart, TConstArrayView<FVector> PelletTraceEnds, TArrayView<TArray<FHitResult>> PelletHitResults) const
+{
+	const int32 NumPellets = PelletTraceEnds.Num();
+	check(PelletHitResults.Num() == NumPellets);
+
+	OutPelletData.NumPellets = NumPellets;
+	OutPelletData.TraceStart = TraceStart;
+	OutPelletData.Hits.Reset(NumPellets);
+
+	TArray<float, TInlineAllocator<4>> DamageMultipliers;
+
+	for (int32 PelletIndex = 0; PelletIndex < NumPellets; ++PelletIndex)
+	{
+		ResolvePenetration(PelletHitResults[PelletIndex], DamageMultipliers);
+
+		if (PelletHitResults[PelletIndex].Num() == 0)
+		{
+			FHeroesPelletHit& PelletMiss = OutPelletData.Hits.AddDefaulted_GetRef();
+			PelletMiss.ImpactPoint = PelletTraceEnds[PelletIndex];
+			PelletMiss.ImpactNormal = FVector::ZeroVector;
+			PelletMiss.PelletIndex = PelletIndex;
+			continue;
+		}
+
+		for (int32 HitIndex = 0; HitIndex < PelletHitResults[PelletIndex].Num(); ++HitIndex)
+		{
+			const FHitResult& HitResult = PelletHitResults[PelletIndex][HitIndex];
+
+			FHeroesPelletHit& PelletHit = OutPelletData.Hits.AddDefaulted_GetRef();
+			PelletHit.Actor = HitResult.GetActor();
+			PelletHit.ImpactPoint = HitResult.ImpactPoint;
+			PelletHit.ImpactNormal = HitResult.ImpactNormal;
+			PelletHit.BoneName = HitResult.BoneName;
+			PelletHit.PelletIndex = PelletIndex;
+			PelletHit.DamageMultiplier = DamageMultipliers[HitIndex];
+		}
+	}
+}
+
+void AHeroesGATA_Trace::ResolvePenetration(TArray<FHitResult>& InOutHits, TArray<float, TInlineAllocator<4>>& OutDamageMultipliers) const
+{
+	OutDamageMultipliers.Reset();
+
+	// Multi-traces return their hits in order, but hits with the same distance aren't guaranteed to stay in order.
+	InOutHits.StableSort([](const FHitResult& A, const FHitResult& B) { return A.Distance < B.Distance; });
+
+	const UWeaponStaticDataAsset* WeaponData = WeaponItemTrait ? WeaponItemTrait->StaticData.Get() : nullptr;
+	const bool bLimitPenetration = WeaponData && WeaponData->bLimitPenetration;
+	const UHeroesPhysicalMaterial* DefaultMaterial = GetDefault<UHeroesPhysicalMaterial>();
+
+	float RemainingBudget = bLimitPenetration ? WeaponData->PenetrationBudget : 0.0f;
+	float DamageMultiplier = 1.0f;
+	bool bStopped = false;
+	int32 NumResolved = 0;
+
+	for (int32 HitIndex = 0; HitIndex < InOutHits.Num(); ++HitIndex)
+	{
+		const AActor* HitActor = InOutHits[HitIndex].GetActor();
+
+		/* Merge hits on an actor that was already hit into its first hit, keeping whichever bone was hit for critical
+		 * hits. This is still done after the shot stops, since an actor's mesh is usually hit after its capsule. */
+		int32 FirstHitIndex = INDEX_NONE;
+		if (HitActor)
+		{
+			for (int32 ResolvedIndex = 0; ResolvedIndex < NumResolved; ++ResolvedIndex)
+			{
+				if (InOutHits[ResolvedIndex].GetActor() == HitActor)
+				{
+					FirstHitIndex = ResolvedIndex;
+					break;
+				}
+			}
+		}
+
+		if (FirstHitIndex != INDEX_NONE)
+		{
+			if (InOutHits[FirstHitIndex].BoneName.IsNone())
+			{
+				InOutHits[FirstHitIndex].BoneName = InOutHits[HitIndex].BoneName;
+			}
+
+			continue;
+		}
+
+		if (bStopped)
+		{
+			continue;
+		}
+
+		if (NumResolved != HitIndex)
+		{
+			InOutHits[NumResolved] = MoveTemp(InOutHits[HitIndex]);
+		}
+
+		OutDamageMultipliers.Add(DamageMultiplier);
+		const FHitResult& ResolvedHit = InOutHits[NumResolved++];
+
+		if (!bLimitPenetration)
+		{
+			continue;
+		}
+
+		// Pass through the hit surface if the shot can afford to. Otherwise, the shot stops at this hit.
+		const UHeroesPhysicalMaterial* Material = Cast<UHeroesPhysicalMaterial>(ResolvedHit.PhysMaterial.Get());
+		Material = Material ? Material : DefaultMaterial;
+
+		RemainingBudget -= Material->PenetrationCost;
+		bStopped = RemainingBudget < 0.0f;
+		DamageMultiplier *= Material->PenetrationDamageMultiplier;
+	}
+
+	InOutHits.SetNum(NumResolved, false);
+}
+
+bool AHeroesGATA_Trace::ShouldUseAsyncTraces() const
+{
+	// Async traces delay target data by a frame, which is only acceptable when the server doesn't have to wait for a client.
+	const FGameplayAbilityActorInfo* ActorInfo = OwningAbility ? OwningAbility->GetCurrentActorInfo() : nullptr;
+	return bUseAsyncTraces && ShouldProduceTargetDataOnServer && ActorInfo && ActorInfo->IsNetAuthority() && CVarAsyncServerTraces.GetValueOnGameThread();
+}
+
+void AHeroesGATA_Trace::QueueAsyncTraces(AActor* InSourceActor, double ShotTime)
+{
+	const FCollisionQueryParams& Params = TraceQueryParams;
+
+	check(PrimaryPC);
+
+	FVector ViewStart;
+	FRotator ViewRot;
+	PrimaryPC->GetPlayerViewPoint(ViewStart, ViewRot);
+
+	if (!AsyncTraceDelegate.IsBound())
+	{
+		AsyncTraceDelegate.BindUObject(this, &AHeroesGATA_Trace::OnAsyncTraceCompleted);
+	}
+
+	const int32 NumPellets = GetPelletCount();
+
+	FHeroesPendingAsyncShot& Shot = PendingAsyncShots.AddDefaulted_GetRef();
+	Shot.ShotId = NextAsyncShotId++ & AsyncShotIdMask;
+	Shot.ShotTime = ShotTime;
+	Shot.ShotIndex = CurrentShotIndex;
+	Shot.SpreadSeed = CurrentSpreadSeed;
+	Shot.WeaponHeat = CurrentWeaponHeat;
+	Shot.TraceStart = ViewStart;
+	Shot.PelletTraceEnds.SetNumUninitialized(NumPellets);
+	Shot.PelletHitResults.SetNum(NumPellets);
+	Shot.NumPendingTraces = NumPellets;
+
+	GetPelletDirections(ViewRot, CurrentSpreadSeed, CurrentWeaponHeat, IsAiming(), Shot.PelletTraceEnds);
+
+	// Queue each pellet's trace, tagging it with its shot and pellet so its results can be matched up later.
+	UWorld* World = InSourceActor->GetWorld();
+	for (int32 PelletIndex = 0; PelletIndex < NumPellets; ++PelletIndex)
+	{
+		Shot.PelletTraceEnds[PelletIndex] = ViewStart + (Shot.PelletTraceEnds[PelletIndex] * MaxRange);
+
+		const uint32 UserData = (Shot.ShotId << AsyncShotIdShift) | (uint32)PelletIndex;
+		World->AsyncLineTraceByProfile(EAsyncTraceType::Multi, ViewStart, Shot.PelletTraceEnds[PelletIndex], TraceProfile.Name, Params, &AsyncTraceDelegate, UserData);
+	}
+
+	CurrentTraceEnd = (NumPellets > 1) ? ViewStart + (ViewRot.Vector() * MaxRange) : Shot.PelletTraceEnds[0];
+	SetActorLocationAndRotation(CurrentTraceEnd, SourceActor->GetActorRotation());
+}
+
+void AHeroesGATA_Trace::OnAsyncTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	const uint32 ShotId = TraceDatum.UserData >> AsyncShotIdShift;
+	const int32 PelletIndex = TraceDatum.UserData & ((1 << AsyncShotIdShift) - 1);
+
+	// The shot may have been discarded if targeting was cancelled.
+	const int32 ShotArrayIndex = PendingAsyncShots.IndexOfByPredicate([ShotId](const FHeroesPendingAsyncShot& PendingShot) { return PendingShot.ShotId == ShotId; });
+	if (ShotArrayIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	FHeroesPendingAsyncShot& Shot = PendingAsyncShots[ShotArrayIndex];
+	if (!Shot.PelletHitResults.IsValidIndex(PelletIndex))
+	{
+		return;
+	}
+
+	Shot.PelletHitResults[PelletIndex] = MoveTemp(TraceDatum.OutHits);
+	if (--Shot.NumPendingTraces > 0)
+	{
+		return;
+	}
+
+	// Every trace of this shot has completed, so its target data can be produced.
+	FGameplayAbilityTargetDataHandle Data;
+
+	if (Shot.PelletHitResults.Num() > 1)
+	{
+		FHeroesGameplayAbilityTargetData_PelletHits* PelletData = new FHeroesGameplayAbilityTargetData_PelletHits();
+		PelletData->ShotTime = Shot.ShotTime;
+		PelletData->ShotIndex = Shot.ShotIndex;
+		PelletData->SpreadSeed = Shot.SpreadSeed;
+		PelletData->WeaponHeat = Shot.WeaponHeat;
+		PackPelletHits(*PelletData, Shot.TraceStart, Shot.PelletTraceEnds, Shot.PelletHitResults);
+		Data.Add(PelletData);
+	}
+	else
+	{
+		TArray<FHitResult>& HitResults = Shot.PelletHitResults[0];
+		if (HitResults.Num() < 1)
+		{
+			HitResults.Add(MakeMissHitResult(Shot.TraceStart, Shot.PelletTraceEnds[0]));
+		}
+
+		TArray<float, TInlineAllocator<4>> DamageMultipliers;
+		ResolvePenetration(HitResults, DamageMultipliers);
+
+		for (int32 HitIndex = 0; HitIndex < HitResults.Num(); ++HitIndex)
+		{
+			Data.Add(new FHeroesGameplayAbilityTargetData_SingleTargetHit(HitResults[HitIndex], Shot.ShotTime, Shot.ShotIndex, Shot.SpreadSeed, Shot.WeaponHeat, DamageMultipliers[HitIndex]));
+		}
+	}
+
+#if HEROES_SHOT_TELEMETRY
+	const bool bAiming = IsAiming();
+	RecordShotTelemetry(Data, GetWorld(), [this, bAiming](float WeaponHeat) { return GetSpread(WeaponHeat, bAiming); }, true);
+#endif
+
+	PendingAsyncShots.RemoveAt(ShotArrayIndex, 1, false);
+
+	TargetDataReadyDelegate.Broadcast(Data);
+}
@@ -4,9 +4,38 @@
 
 #include "CoreMinimal.h"
 #include "Abilities/GameplayAbilityTargetActor.h"
+#include "WorldCollision.h"
 #include "HeroesGATA_Trace.generated.h"
 
+class UInventoryItemInstance;
 class UWeaponItemTrait;
+struct FHeroesGameplayAbilityTargetData_PelletHits;
+
+/**
+ * A shot whose traces have been queued with the world's async trace API, waiting for their results.
+ */
+struct FHeroesPendingAsyncShot
+{
+	/** Identifies this shot in its traces' user data. */
+	uint32 ShotId = 0;
+
+	/** The shot's state, copied into its target data once its traces complete. */
+	double ShotTime = 0.0;
+	uint16 ShotIndex = 0;
+	int32 SpreadSeed = 0;
+	float WeaponHeat = 0.0f;
+
+	FVector TraceStart = FVector::ZeroVector;
+
+	/** The end of each pellet's trace. Single-pellet shots have one pellet. */
+	TArray<FVector, TInlineAllocator<1>> PelletTraceEnds;
+
+	/** The results of each pellet's trace. */
+	TArray<TArray<FHitResult>, TInlineAllocator<1>> PelletHitResults;
+
+	/** The number of this shot's traces that haven't completed yet. */
+	int32 NumPendingTraces = 0;
+};
 
 /**
  * A reusable and re-configurable trace target actor. Subclass this with custom trace shapes.
@@ -29,19 +58,110 @@ public:
 		UPARAM(DisplayName = "Ignore Blocking Hits") bool bInIgnoreBlockingHits = false,
 		UPARAM(DisplayName = "Should Produce Target Data on Server") bool bInShouldProduceTargetDataOnServer = false,
 		UPARAM(DisplayName = "Max Range") float InMaxRange = 999999.0f,
-		UPARAM(DisplayName = "Weapon Item Trait") UWeaponItemTrait* InWeaponItemTrait = nullptr
+		UPARAM(DisplayName = "Weapon Item") UInventoryItemInstance* InWeaponItem = nullptr,
+		UPARAM(DisplayName = "Use Async Traces") bool bInUseAsyncTraces = false
 	);
 
+	/** The weapon item instance that this target actor is currently configured for. */
+	UInventoryItemInstance* GetWeaponItem() const { return WeaponItem; }
+
 public:
 
 	virtual void ConfirmTargetingAndContinue() override;
 
+	/** Cancels targeting, discarding any shots whose async traces are still pending. */
 	virtual void CancelTargeting() override;
 
+	/** Validates target data received from the client. See ValidateReplicatedShot. */
+	virtual bool OnReplicatedTargetDataReceived(FGameplayAbilityTargetDataHandle& Data) const override;
+
+	/**
+	 * Validates a shot's target data received from the client. This is the single entry point for server-side shot
+	 * validation: each shot's spread, heat, and spread seed are re-simulated, and its hits are re-verified against the
+	 * lag-compensated hitboxes of the heroes they hit. Invalid hits are converted into misses instead of rejecting the
+	 * target data, so the shot still happens. Target data that has already been validated (e.g. because more than one
+	 * task received it) isn't validated again.
+	 *
+	 * @param Ability	The ability that fired the shot.
+	 * @param Data		The shot's target data. Modified in-place.
+	 * @return			True if every hit was accepted as-is.
+	 */
+	bool ValidateReplicatedShot(const UGameplayAbility* Ability, FGameplayAbilityTargetDataHandle& Data) const;
+
 protected:
 
 	virtual TArray<FHitResult> PerformTrace(AActor* InSourceActor);
 
+	/** Traces every pellet of a multi-pellet shot as a batch, and packs their hits into the given target data. Used
+	 * instead of PerformTrace when the weapon fires more than one pellet. */
+	virtual void PerformPelletTraces(AActor* InSourceActor, FHeroesGameplayAbilityTargetData_PelletHits& OutPelletData);
+
+	/** Returns the direction of a shot aimed with the given rotation. The shot's spread is randomized with the given
+	 * seed, so the same shot can be reproduced on the server. */
+	FVector GetShotDirection(const FRotator& AimRotation, int32 SpreadSeed, float WeaponHeat, bool bAiming) const;
+
+	/** Writes the direction of every pellet of a shot aimed with the given rotation. Every pellet's spread is drawn
+	 * from the same seeded stream, in order. The first pellet's direction matches GetShotDirection. */
+	void GetPelletDirections(const FRotator& AimRotation, int32 SpreadSeed, float WeaponHeat, bool bAiming, TArrayView<FVector> OutDirections) const;
+
+	/** Returns this target actor's weapon's horizontal and vertical spread, in degrees, at the given heat. */
+	FVector GetSpread(float WeaponHeat, bool bAiming) const;
+
+	/** Returns the number of pellets fired by each shot of this target actor's weapon. */
+	int32 GetPelletCount() const;
+
+	/** Whether the owner of this target actor's weapon is aiming down its sights, which reduces its spread. */
+	bool IsAiming() const;
+
+	/** Resolves the penetration of every pellet's hits and packs them into the given target data. Pellets that didn't
+	 * hit anything are stored at the end of their trace. */
+	void PackPelletHits(FHeroesGameplayAbilityTargetData_PelletHits& OutPelletData, const FVector& TraceStart, TConstArrayView<FVector> PelletTraceEnds, TArrayView<TArray<FHitResult>> PelletHitResults) const;
+
+	/**
+	 * Resolves which of a single trace's hits are hit by the shot. Hits are sorted by distance, and hits on an actor
+	 * that was already hit (e.g. a character's capsule and then its mesh) are merged into its first hit. If this
+	 * target actor's weapon limits penetration, each hit surface spends some of the shot's penetration budget and
+	 * attenuates the damage of everything behind it; hits beyond the last surface the shot could afford to pass through
+	 * are discarded.
+	 *
+	 * @param InOutHits				The trace's hits. Replaced with the resolved hits.
+	 * @param OutDamageMultipliers	The damage multiplier of each resolved hit.
+	 */
+	void ResolvePenetration(TArray<FHitResult>& InOutHits, TArray<float, TInlineAllocator<4>>& OutDamageMultipliers) const;
+
+	/** Converts hits whose trace direction could not have been produced by their claimed spread seed and weapon heat,
+	 * from an aim that the shooter had when the shot was fired, into misses. Fires the server's copy of the weapon for
+	 * each new shot. Returns true if every hit was accepted. */
+	bool ValidateShotSpread(const UGameplayAbility* Ability, FGameplayAbilityTargetDataHandle& Data) const;
+
+protected:
+
+	/** Whether shots are traced asynchronously. Only used when this target actor produces target data on the server. */
+	bool ShouldUseAsyncTraces() const;
+
+	/** Queues the current shot's traces with the world's async trace API. The shot's target data is produced when its
+	 * traces complete, on the next frame. */
+	void QueueAsyncTraces(AActor* InSourceActor, double ShotTime);
+
+	/** Collects the results of a queued trace. Produces its shot's target data once all of the shot's traces have
+	 * completed. */
+	void OnAsyncTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
+	/** Whether shots should be traced asynchronously when producing target data on the server. Async traces are
+	 * resolved a frame later, but don't block the game thread. */
+	bool bUseAsyncTraces = false;
+
+private:
+
+	/** Shots whose async traces are still pending. */
+	TArray<FHeroesPendingAsyncShot> PendingAsyncShots;
+
+	/** The ID of the next shot traced asynchronously. */
+	uint32 NextAsyncShotId = 0;
+
+	/** Bound to OnAsyncTraceCompleted. */
+	FTraceDelegate AsyncTraceDelegate;
+
 public:
 
 	UPROPERTY(BlueprintReadOnly)
@@ -55,6 +175,45 @@ protected:
 	bool bShouldProduceTargetDataOnServer;
 	float MaxRange;
 
+	/** The query parameters used by every trace of this target actor. Built when this target actor is configured. */
+	FCollisionQueryParams TraceQueryParams;
+
+	/** The weapon item instance firing this trace. Weapon runtime data (e.g. heat) is read from this instance. */
+	UPROPERTY()
+	TObjectPtr<UInventoryItemInstance> WeaponItem;
+
+	/** The weapon trait of @WeaponItem. Weapon static data is read from this trait. */
 	UPROPERTY()
 	UWeaponItemTrait* WeaponItemTrait;
+
+	/** The seed used to randomize the spread of the shot currently being traced. */
+	int32 CurrentSpreadSeed = 0;
+
+	/** The weapon heat used to determine the spread of the shot currently being traced. */
+	float CurrentWeaponHeat = 0.0f;
+
+	/** The index of the shot currently being traced within its ability activation. */
+	uint16 CurrentShotIndex = 0;
+
+private:
+
+	/** The activation prediction key of the ability activation whose shots are currently being counted. */
+	FPredictionKey ShotPredictionKey;
+
+	/** The index of the next shot fired during the current ability activation. */
+	uint16 NextShotIndex = 0;
+
+	/** The activation prediction key of the ability activation whose shots are currently being validated by the
+	 * server. */
+	mutable FPredictionKey ValidatedPredictionKey;
+
+	/** The highest shot index validated by the server during the current ability activation. Clients can't re-use
+	 * a shot index to re-use a favorable spread seed. */
+	mutable int32 LastValidatedShotIndex = INDEX_NONE;
+
+	/** The most recent target data validated by the server, so the same data isn't validated twice. */
+	mutable TWeakPtr<FGameplayAbilityTargetData> LastValidatedTargetData;
+
+	/** Whether every hit in @LastValidatedTargetData was accepted. */
+	mutable bool bLastValidatedTargetDataAccepted = true;
 };
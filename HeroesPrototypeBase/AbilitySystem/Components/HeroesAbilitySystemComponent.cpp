@@ -3,3 +3,81 @@
 
 #include "AbilitySystem/Components/HeroesAbilitySystemComponent.h"
 
+#include "AbilitySystem/Auxiliary/TargetActors/HeroesGATA_Trace.h"
+#include "Inventory/InventoryItemDefinition.h"
+#include "Inventory/InventoryItemInstance.h"
+#include "Inventory/ItemTraits/WeaponItemTrait.h"
+#include "Inventory/ItemTraits/WeaponStaticDataAsset.h"
+
+void UHeroesAbilitySystemComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	for (const FHeroesCachedTargetActor& CachedTargetActor : CachedTargetActors)
+	{
+		if (IsValid(CachedTargetActor.TargetActor))
+		{
+			CachedTargetActor.TargetActor->Destroy();
+		}
+	}
+
+	CachedTargetActors.Empty();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+AHeroesGATA_Trace* UHeroesAbilitySystemComponent::GetWeaponTargetActor(UInventoryItemInstance* WeaponItem)
+{
+	const UInventoryItemDefinition* ItemDefinition = IsValid(WeaponItem) ? WeaponItem->GetItemDefinition() : nullptr;
+	const UWeaponItemTrait* WeaponTrait = ItemDefinition ? ItemDefinition->FindTraitByClass<UWeaponItemTrait>() : nullptr;
+	const UWeaponStaticDataAsset* WeaponData = WeaponTrait ? WeaponTrait->StaticData.Get() : nullptr;
+	AActor* Avatar = GetAvatarActor();
+
+	if (!WeaponData || !IsValid(Avatar))
+	{
+		return nullptr;
+	}
+
+	UClass* TargetActorClass = WeaponData->TargetActorClass ? WeaponData->TargetActorClass.Get() : AHeroesGATA_Trace::StaticClass();
+
+	// Find this weapon's cached target actor, discarding any that have been destroyed externally.
+	FHeroesCachedTargetActor* CachedTargetActor = CachedTargetActors.FindByPredicate([TargetActorClass, WeaponTrait](const FHeroesCachedTargetActor& Other)
+	{
+		return Other.TargetActorClass == TargetActorClass && Other.WeaponTrait == WeaponTrait;
+	});
+
+	if (CachedTargetActor && !IsValid(CachedTargetActor->TargetActor))
+	{
+		CachedTargetActors.RemoveAtSwap(CachedTargetActor - CachedTargetActors.GetData(), 1, false);
+		CachedTargetActor = nullptr;
+	}
+
+	// Spawn a new target actor if this weapon doesn't have one yet.
+	if (!CachedTargetActor)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = GetOwner();
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		AHeroesGATA_Trace* TargetActor = GetWorld()->SpawnActor<AHeroesGATA_Trace>(TargetActorClass, FTransform::Identity, SpawnParams);
+		if (!TargetActor)
+		{
+			return nullptr;
+		}
+
+		CachedTargetActor = &CachedTargetActors.AddDefaulted_GetRef();
+		CachedTargetActor->TargetActorClass = TargetActorClass;
+		CachedTargetActor->WeaponTrait = WeaponTrait;
+		CachedTargetActor->TargetActor = TargetActor;
+	}
+
+	// Only re-configure the target actor when its weapon or avatar changes, so its query parameters aren't rebuilt.
+	AHeroesGATA_Trace* TargetActor = CachedTargetActor->TargetActor;
+	if (TargetActor->SourceActor != Avatar || TargetActor->GetWeaponItem() != WeaponItem)
+	{
+		TargetActor->Configure(Avatar, WeaponData->TraceProfile, WeaponData->bIgnoreBlockingHits, WeaponData->bProduceTargetDataOnServer, WeaponData->MaxRange, WeaponItem, WeaponData->bUseAsyncTraces);
+	}
+
+	// Target actors only trace when confirmed, so they never need to tick.
+	TargetActor->SetActorTickEnabled(false);
+
+	return TargetActor;
+}
@@ -6,6 +6,30 @@
 #include "AbilitySystemComponent.h"
 #include "HeroesAbilitySystemComponent.generated.h"
 
+class AHeroesGATA_Trace;
+class UInventoryItemInstance;
+class UWeaponItemTrait;
+
+/**
+ * A target actor cached by an ability system component, so it can be re-used for every shot of a weapon.
+ */
+USTRUCT()
+struct FHeroesCachedTargetActor
+{
+	GENERATED_BODY()
+
+	/** The class of the cached target actor. */
+	UPROPERTY()
+	TObjectPtr<UClass> TargetActorClass;
+
+	/** The weapon trait that the target actor was cached for. */
+	UPROPERTY()
+	TObjectPtr<const UWeaponItemTrait> WeaponTrait;
+
+	UPROPERTY()
+	TObjectPtr<AHeroesGATA_Trace> TargetActor;
+};
+
 /**
  * The ability system component class used by all actors in this project that want to utilize the gameplay abilities
  * system. This component provides an interface for its owning actor to interact with GAS.
@@ -14,5 +38,35 @@ UCLASS(ClassGroup = AbilitySystem, meta = (BlueprintSpawnableComponent))
 class HEROESPROTOTYPEBASE_API UHeroesAbilitySystemComponent : public UAbilitySystemComponent
 {
 	GENERATED_BODY()
-	
+
+	// Initialization.
+
+public:
+
+	/** Destroys every cached target actor. */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+
+
+	// Targeting.
+
+public:
+
+	/**
+	 * Returns the target actor used to trace the given weapon's shots. Target actors are cached by their class and
+	 * weapon trait, so they're only spawned the first time they're needed; they're only re-configured when their
+	 * weapon or avatar changes. Cached target actors never tick.
+	 *
+	 * @param WeaponItem		The weapon whose target actor to retrieve. Must have a weapon trait.
+	 * @return					The weapon's configured target actor, or nullptr if the item isn't a weapon.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Heroes|AbilitySystem|Targeting")
+	AHeroesGATA_Trace* GetWeaponTargetActor(UInventoryItemInstance* WeaponItem);
+
+private:
+
+	/** Target actors that have been spawned for this ability system's weapons. There are rarely more than a few, so
+	 * these are searched linearly. */
+	UPROPERTY()
+	TArray<FHeroesCachedTargetActor> CachedTargetActors;
 };
@@ -219,6 +219,10 @@ void UDamageExecution::Execute_Implementation(const FGameplayEffectCustomExecuti
 	}
 
 
+	// Apply the context's damage multiplier (e.g. from surfaces that a shot passed through before hitting the target).
+	DamageDone *= HeroesContext->GetDamageMultiplier();
+
+
 	// Apply incoming and outgoing damage multipliers if this is not "true damage."
 	if (!DamageExecutionDataAsset->bTrueDamage)
 	{
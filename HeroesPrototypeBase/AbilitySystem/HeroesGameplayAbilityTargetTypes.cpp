@@ -0,0 +1,269 @@
+// Copyright Samuel Reitich 2024.
+
+
+#include "AbilitySystem/HeroesGameplayAbilityTargetTypes.h"
+
+#include "AbilitySystemBlueprintLibrary.h"
+#include "AbilitySystemComponent.h"
+#include "AbilitySystem/HeroesGameplayEffectContext.h"
+#include "AbilitySystem/Components/HealthComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+
+/** Serializes the given hit actor's reference as a net GUID. */
+static void SerializeHitActor(FArchive& Ar, UPackageMap* Map, AActor*& HitActor)
+{
+	UObject* ActorObject = HitActor;
+	Map->SerializeObject(Ar, AActor::StaticClass(), ActorObject);
+
+	if (Ar.IsLoading())
+	{
+		HitActor = Cast<AActor>(ActorObject);
+	}
+}
+
+/**
+ * Serializes the given bone as its index in the hit actor's critical hit mesh instead of as a name. Bones are only
+ * used to determine critical hits, so bones of actors without a critical hit mesh aren't serialized. Must be called
+ * after the hit actor is serialized.
+ */
+static void SerializeBoneName(FArchive& Ar, const AActor* HitActor, FName& BoneName)
+{
+	const UHealthComponent* HealthComponent = UHealthComponent::FindHealthComponent(HitActor);
+	const USkeletalMeshComponent* CriticalHitMesh = HealthComponent ? HealthComponent->CriticalHitMesh : nullptr;
+
+	// Bone indices are offset by one, so 0 can represent no bone.
+	uint32 PackedBoneIndex = 0;
+	if (Ar.IsSaving() && CriticalHitMesh && !BoneName.IsNone())
+	{
+		PackedBoneIndex = CriticalHitMesh->GetBoneIndex(BoneName) + 1;
+	}
+
+	Ar.SerializeIntPacked(PackedBoneIndex);
+
+	if (Ar.IsLoading())
+	{
+		BoneName = (CriticalHitMesh && PackedBoneIndex > 0) ? CriticalHitMesh->GetBoneName(PackedBoneIndex - 1) : NAME_None;
+	}
+}
+
+/** Serializes a weapon heat from 0.0 to 1.0 as a single byte. */
+static void SerializeWeaponHeat(FArchive& Ar, float& WeaponHeat)
+{
+	uint8 QuantizedHeat = FMath::RoundToInt(FMath::Clamp(WeaponHeat, 0.0f, 1.0f) * 255.0f);
+	Ar << QuantizedHeat;
+
+	if (Ar.IsLoading())
+	{
+		WeaponHeat = QuantizedHeat / 255.0f;
+	}
+}
+
+/** Serializes a damage multiplier from 0.0 to 1.0. Most hits aren't attenuated, so unattenuated hits are sent as a
+ * single bit. */
+static void SerializeDamageMultiplier(FArchive& Ar, float& DamageMultiplier)
+{
+	uint8 bAttenuated = DamageMultiplier < 1.0f;
+	Ar.SerializeBits(&bAttenuated, 1);
+
+	uint8 QuantizedDamageMultiplier = FMath::RoundToInt(FMath::Clamp(DamageMultiplier, 0.0f, 1.0f) * 255.0f);
+	if (bAttenuated)
+	{
+		Ar << QuantizedDamageMultiplier;
+	}
+
+	if (Ar.IsLoading())
+	{
+		DamageMultiplier = bAttenuated ? QuantizedDamageMultiplier / 255.0f : 1.0f;
+	}
+}
+
+/** Serializes a shot time as a whole number of milliseconds. A float's precision falls as the server's uptime grows, so
+ * times are sent as an integer instead, which is exact regardless of uptime. See QuantizeShotTime. */
+static void SerializeShotTime(FArchive& Ar, double& ShotTime)
+{
+	uint64 ShotTimeMilliseconds = (uint64)FMath::RoundToDouble(FMath::Max(ShotTime, 0.0) * 1000.0);
+	Ar.SerializeIntPacked64(ShotTimeMilliseconds);
+
+	if (Ar.IsLoading())
+	{
+		ShotTime = ShotTimeMilliseconds / 1000.0;
+	}
+}
+
+bool FHeroesGameplayAbilityTargetData_SingleTargetHit::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	AActor* HitActor = HitResult.GetActor();
+	SerializeHitActor(Ar, Map, HitActor);
+
+	FVector_NetQuantize10 ImpactPoint = HitResult.ImpactPoint;
+	ImpactPoint.NetSerialize(Ar, Map, bOutSuccess);
+
+	FVector_NetQuantizeNormal ImpactNormal = HitResult.ImpactNormal;
+	ImpactNormal.NetSerialize(Ar, Map, bOutSuccess);
+
+	// The trace's origin is sent relative to the impact point. Traces end at their impact point, or at their end if they miss.
+	FVector_NetQuantize OriginDelta = HitResult.TraceStart - HitResult.ImpactPoint;
+	OriginDelta.NetSerialize(Ar, Map, bOutSuccess);
+
+	uint8 bBlockingHit = HitResult.bBlockingHit;
+	Ar.SerializeBits(&bBlockingHit, 1);
+
+	SerializeBoneName(Ar, HitActor, HitResult.BoneName);
+
+	SerializeShotTime(Ar, ShotTime);
+	Ar << SpreadSeed;
+	SerializeWeaponHeat(Ar, WeaponHeat);
+
+	uint32 PackedShotIndex = ShotIndex;
+	Ar.SerializeIntPacked(PackedShotIndex);
+
+	SerializeDamageMultiplier(Ar, DamageMultiplier);
+
+	if (Ar.IsLoading())
+	{
+		const FName BoneName = HitResult.BoneName;
+
+		HitResult = FHitResult(HitActor, nullptr, ImpactPoint, ImpactNormal);
+		HitResult.ImpactPoint = ImpactPoint;
+		HitResult.ImpactNormal = ImpactNormal;
+		HitResult.TraceStart = ImpactPoint + OriginDelta;
+		HitResult.TraceEnd = ImpactPoint;
+		HitResult.BoneName = BoneName;
+		HitResult.bBlockingHit = bBlockingHit;
+		ShotIndex = PackedShotIndex;
+	}
+
+	return true;
+}
+
+void FHeroesGameplayAbilityTargetData_SingleTargetHit::AddTargetDataToContext(FGameplayEffectContextHandle& Context, bool bIncludeActorArray) const
+{
+	FGameplayAbilityTargetData_SingleTargetHit::AddTargetDataToContext(Context, bIncludeActorArray);
+
+	if (FHeroesGameplayEffectContext* HeroesContext = FHeroesGameplayEffectContext::GetHeroesContextFromHandle(Context))
+	{
+		HeroesContext->SetDamageMultiplier(DamageMultiplier);
+	}
+}
+
+bool FHeroesPelletHit::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	AActor* HitActor = Actor.Get();
+	SerializeHitActor(Ar, Map, HitActor);
+
+	ImpactPoint.NetSerialize(Ar, Map, bOutSuccess);
+	ImpactNormal.NetSerialize(Ar, Map, bOutSuccess);
+	SerializeBoneName(Ar, HitActor, BoneName);
+	Ar << PelletIndex;
+	SerializeDamageMultiplier(Ar, DamageMultiplier);
+
+	if (Ar.IsLoading())
+	{
+		Actor = HitActor;
+	}
+
+	return true;
+}
+
+FHitResult FHeroesGameplayAbilityTargetData_PelletHits::MakeHitResult(int32 HitIndex) const
+{
+	const FHeroesPelletHit& PelletHit = Hits[HitIndex];
+
+	FHitResult HitResult(PelletHit.Actor.Get(), nullptr, PelletHit.ImpactPoint, PelletHit.ImpactNormal);
+	HitResult.ImpactPoint = PelletHit.ImpactPoint;
+	HitResult.ImpactNormal = PelletHit.ImpactNormal;
+	HitResult.TraceStart = TraceStart;
+	HitResult.TraceEnd = PelletHit.ImpactPoint;
+	HitResult.BoneName = PelletHit.BoneName;
+	HitResult.bBlockingHit = PelletHit.Actor.IsValid();
+
+	return HitResult;
+}
+
+TArray<TWeakObjectPtr<AActor>> FHeroesGameplayAbilityTargetData_PelletHits::GetActors() const
+{
+	TArray<TWeakObjectPtr<AActor>> Actors;
+
+	for (const FHeroesPelletHit& PelletHit : Hits)
+	{
+		if (PelletHit.Actor.IsValid())
+		{
+			Actors.AddUnique(PelletHit.Actor);
+		}
+	}
+
+	return Actors;
+}
+
+TArray<FActiveGameplayEffectHandle> FHeroesGameplayAbilityTargetData_PelletHits::ApplyGameplayEffectSpec(FGameplayEffectSpec& Spec, FPredictionKey PredictionKey)
+{
+	TArray<FActiveGameplayEffectHandle> AppliedHandles;
+
+	UAbilitySystemComponent* InstigatorASC = Spec.GetContext().GetInstigatorAbilitySystemComponent();
+	if (!ensure(InstigatorASC))
+	{
+		return AppliedHandles;
+	}
+
+	for (int32 HitIndex = 0; HitIndex < Hits.Num(); ++HitIndex)
+	{
+		UAbilitySystemComponent* TargetASC = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(Hits[HitIndex].Actor.Get());
+		if (!TargetASC)
+		{
+			continue;
+		}
+
+		/* Each pellet needs its own spec and context. Otherwise, every pellet's hit would accumulate in the same
+		 * context. */
+		FGameplayEffectSpec SpecToApply(Spec);
+		FGameplayEffectContextHandle EffectContext = SpecToApply.GetContext().Duplicate();
+		EffectContext.AddHitResult(MakeHitResult(HitIndex), true);
+		SpecToApply.SetContext(EffectContext);
+
+		if (FHeroesGameplayEffectContext* HeroesContext = FHeroesGameplayEffectContext::GetHeroesContextFromHandle(EffectContext))
+		{
+			HeroesContext->SetDamageMultiplier(Hits[HitIndex].DamageMultiplier);
+		}
+
+		AppliedHandles.Append(InstigatorASC->ApplyGameplayEffectSpecToTarget(SpecToApply, TargetASC, PredictionKey));
+	}
+
+	return AppliedHandles;
+}
+
+bool FHeroesGameplayAbilityTargetData_PelletHits::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	SerializeShotTime(Ar, ShotTime);
+	Ar << ShotIndex;
+	Ar << SpreadSeed;
+	SerializeWeaponHeat(Ar, WeaponHeat);
+	Ar << NumPellets;
+	TraceStart.NetSerialize(Ar, Map, bOutSuccess);
+
+	uint32 NumHits = Hits.Num();
+	Ar.SerializeIntPacked(NumHits);
+
+	// Each pellet can hit a few actors at most; anything beyond that is malformed.
+	if (Ar.IsLoading())
+	{
+		if (NumHits > (uint32)NumPellets * 8)
+		{
+			Ar.SetError();
+			bOutSuccess = false;
+			return false;
+		}
+
+		Hits.SetNum(NumHits);
+	}
+
+	for (FHeroesPelletHit& PelletHit : Hits)
+	{
+		PelletHit.NetSerialize(Ar, Map, bOutSuccess);
+	}
+
+	return true;
+}
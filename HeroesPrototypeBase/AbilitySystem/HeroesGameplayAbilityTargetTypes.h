@@ -0,0 +1,220 @@
+// Copyright Samuel Reitich 2024.
+
+#pragma once
+
+#include "Abilities/GameplayAbilityTargetTypes.h"
+
+#include "HeroesGameplayAbilityTargetTypes.generated.h"
+
+/**
+ * Target data for a single hit that also carries the time at which the hit was claimed and the state used to compute
+ * the shot's spread. The server uses the time to rewind hit characters' hitboxes when validating the hit (see
+ * UHeroesLagCompensationSubsystem), and the spread state to re-simulate the shot's direction (see AHeroesGATA_Trace).
+ */
+USTRUCT()
+struct HEROESPROTOTYPEBASE_API FHeroesGameplayAbilityTargetData_SingleTargetHit : public FGameplayAbilityTargetData_SingleTargetHit
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Default constructor. */
+	FHeroesGameplayAbilityTargetData_SingleTargetHit() : FGameplayAbilityTargetData_SingleTargetHit() {}
+
+	/** Constructor providing the hit, the time at which it was claimed, the shot's spread state, and the hit's damage
+	 * multiplier. */
+	FHeroesGameplayAbilityTargetData_SingleTargetHit(const FHitResult& InHitResult, double InShotTime, uint16 InShotIndex, int32 InSpreadSeed, float InWeaponHeat, float InDamageMultiplier = 1.0f)
+		: FGameplayAbilityTargetData_SingleTargetHit(InHitResult)
+		, ShotTime(InShotTime)
+		, ShotIndex(InShotIndex)
+		, SpreadSeed(InSpreadSeed)
+		, WeaponHeat(InWeaponHeat)
+		, DamageMultiplier(InDamageMultiplier)
+	{}
+
+	/** The server world time, as seen by the client, at which this hit was traced. */
+	UPROPERTY()
+	double ShotTime = 0.0;
+
+	/** The index of the shot that produced this hit within its ability activation. */
+	UPROPERTY()
+	uint16 ShotIndex = 0;
+
+	/** The seed used to randomize the shot's spread. Derived from the ability's activation prediction key and the shot
+	 * index, so the server can reproduce it. */
+	UPROPERTY()
+	int32 SpreadSeed = 0;
+
+	/** The weapon's heat when the shot was fired, which determines the shot's spread. */
+	UPROPERTY()
+	float WeaponHeat = 0.0f;
+
+	/** The multiplier applied to damage dealt by this hit, from the surfaces the shot passed through before it. */
+	UPROPERTY()
+	float DamageMultiplier = 1.0f;
+
+	/** Adds this hit's damage multiplier to the context, along with its hit result. */
+	virtual void AddTargetDataToContext(FGameplayEffectContextHandle& Context, bool bIncludeActorArray) const override;
+
+	/** Derives the spread seed for the given shot of an ability activation. */
+	static int32 MakeSpreadSeed(const FPredictionKey& ActivationPredictionKey, uint16 InShotIndex)
+	{
+		return (int32)HashCombine(GetTypeHash(ActivationPredictionKey.Current), GetTypeHash(InShotIndex));
+	}
+
+	/** Weapon heat is replicated as a single byte. Shots quantize their heat before using it, so the server
+	 * re-simulates shots with exactly the same heat as the client. */
+	static float QuantizeWeaponHeat(float Heat)
+	{
+		return FMath::RoundToFloat(FMath::Clamp(Heat, 0.0f, 1.0f) * 255.0f) / 255.0f;
+	}
+
+	/** Shot times are replicated as a whole number of milliseconds. Shots quantize their time before using it, so the
+	 * server re-fires the weapon at exactly the same time as the client. */
+	static double QuantizeShotTime(double Time)
+	{
+		return FMath::RoundToDouble(FMath::Max(Time, 0.0) * 1000.0) / 1000.0;
+	}
+
+	/** Override the function to retrieve this structure's static structure. */
+	virtual UScriptStruct* GetScriptStruct() const override
+	{
+		return FHeroesGameplayAbilityTargetData_SingleTargetHit::StaticStruct();
+	}
+
+	/** Serializes only the parts of the hit result used to apply and validate damage, quantized: the hit actor, the
+	 * impact point and normal, the hit bone's index, and the trace's origin relative to the impact point. The full
+	 * hit result is not serialized. */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FHeroesGameplayAbilityTargetData_SingleTargetHit> : public TStructOpsTypeTraitsBase2<FHeroesGameplayAbilityTargetData_SingleTargetHit>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+/**
+ * A single hit of a pellet fired by a multi-pellet shot. Pellets that don't hit anything are stored as a hit without
+ * an actor at the end of their trace, so they can still be used for cosmetics.
+ */
+USTRUCT()
+struct HEROESPROTOTYPEBASE_API FHeroesPelletHit
+{
+	GENERATED_BODY()
+
+	/** The actor hit by the pellet. Null if the pellet missed. */
+	UPROPERTY()
+	TWeakObjectPtr<AActor> Actor;
+
+	UPROPERTY()
+	FVector_NetQuantize ImpactPoint;
+
+	UPROPERTY()
+	FVector_NetQuantizeNormal ImpactNormal;
+
+	/** The bone hit by the pellet, used for critical hits. */
+	UPROPERTY()
+	FName BoneName;
+
+	/** The index of the pellet within its shot, which determines its spread direction. */
+	UPROPERTY()
+	uint8 PelletIndex = 0;
+
+	/** The multiplier applied to damage dealt by this hit, from the surfaces the pellet passed through before it. */
+	UPROPERTY()
+	float DamageMultiplier = 1.0f;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FHeroesPelletHit> : public TStructOpsTypeTraitsBase2<FHeroesPelletHit>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+/**
+ * Target data for every hit of a single multi-pellet shot (e.g. a shotgun blast). The shot's shared state is stored
+ * once and each hit is stored compactly, so an entire shot is a single target data entry and a single RPC.
+ *
+ * Gameplay effects applied with this target data are applied once for every pellet hit, each with its own hit result.
+ */
+USTRUCT()
+struct HEROESPROTOTYPEBASE_API FHeroesGameplayAbilityTargetData_PelletHits : public FGameplayAbilityTargetData
+{
+	GENERATED_BODY()
+
+public:
+
+	/** The server world time, as seen by the client, at which this shot was traced. */
+	UPROPERTY()
+	double ShotTime = 0.0;
+
+	/** The index of this shot within its ability activation. */
+	UPROPERTY()
+	uint16 ShotIndex = 0;
+
+	/** The seed used to randomize the spread of every pellet. See FHeroesGameplayAbilityTargetData_SingleTargetHit. */
+	UPROPERTY()
+	int32 SpreadSeed = 0;
+
+	/** The weapon's heat when the shot was fired, which determines the pellets' spread. */
+	UPROPERTY()
+	float WeaponHeat = 0.0f;
+
+	/** The number of pellets fired by this shot. */
+	UPROPERTY()
+	uint8 NumPellets = 0;
+
+	/** Where every pellet's trace started. */
+	UPROPERTY()
+	FVector_NetQuantize TraceStart;
+
+	/** Every pellet's hits. Each pellet has at least one entry. */
+	UPROPERTY()
+	TArray<FHeroesPelletHit> Hits;
+
+	/** Builds a full hit result from the given pellet hit. */
+	FHitResult MakeHitResult(int32 HitIndex) const;
+
+	/** Returns every actor hit by a pellet, once each. */
+	virtual TArray<TWeakObjectPtr<AActor>> GetActors() const override;
+
+	/** Applies the given effect once for every pellet hit on an actor with an ASC. Each application uses its own
+	 * context with that pellet's hit result and damage multiplier. */
+	virtual TArray<FActiveGameplayEffectHandle> ApplyGameplayEffectSpec(FGameplayEffectSpec& Spec, FPredictionKey PredictionKey = FPredictionKey()) override;
+
+	virtual bool HasOrigin() const override { return true; }
+
+	virtual FTransform GetOrigin() const override { return FTransform(TraceStart); }
+
+	/** Override the function to retrieve this structure's static structure. */
+	virtual UScriptStruct* GetScriptStruct() const override
+	{
+		return FHeroesGameplayAbilityTargetData_PelletHits::StaticStruct();
+	}
+
+	virtual FString ToString() const override
+	{
+		return TEXT("FHeroesGameplayAbilityTargetData_PelletHits");
+	}
+
+	/** Serializes the shot's shared state and every pellet hit. */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FHeroesGameplayAbilityTargetData_PelletHits> : public TStructOpsTypeTraitsBase2<FHeroesGameplayAbilityTargetData_PelletHits>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
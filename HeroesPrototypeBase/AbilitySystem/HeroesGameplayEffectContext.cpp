@@ -23,5 +23,24 @@ bool FHeroesGameplayEffectContext::NetSerialize(FArchive& Ar, UPackageMap* Map,
 {
 	FGameplayEffectContext::NetSerialize(Ar, Map, bOutSuccess);
 
+	// Damage multipliers are rare, so they're only sent when they're used. They're sent as a single byte.
+	uint8 bHasDamageMultiplier = DamageMultiplier != 1.0f;
+	Ar.SerializeBits(&bHasDamageMultiplier, 1);
+
+	if (bHasDamageMultiplier)
+	{
+		uint8 QuantizedDamageMultiplier = FMath::RoundToInt(FMath::Clamp(DamageMultiplier, 0.0f, 1.0f) * 255.0f);
+		Ar << QuantizedDamageMultiplier;
+
+		if (Ar.IsLoading())
+		{
+			DamageMultiplier = QuantizedDamageMultiplier / 255.0f;
+		}
+	}
+	else if (Ar.IsLoading())
+	{
+		DamageMultiplier = 1.0f;
+	}
+
 	return true;
 }
@@ -33,8 +33,32 @@ public:
   return FHeroesGameplayEffectContext::StaticStruct();
  }
 
+ /** Override the function to duplicate this context with its new fields. */
+ virtual FGameplayEffectContext* Duplicate() const override
+ {
+  FHeroesGameplayEffectContext* NewContext = new FHeroesGameplayEffectContext();
+  *NewContext = *this;
+  if (GetHitResult())
+  {
+   // Does a deep copy of the hit result.
+   NewContext->AddHitResult(*GetHitResult(), true);
+  }
+  return NewContext;
+ }
+
  /** Serializes new fields. */
  virtual bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess) override;
+
+ /** The multiplier applied to damage dealt with this context, e.g. by surfaces that a shot passed through before
+  * hitting its target. */
+ float GetDamageMultiplier() const { return DamageMultiplier; }
+
+ void SetDamageMultiplier(float InDamageMultiplier) { DamageMultiplier = InDamageMultiplier; }
+
+protected:
+
+ UPROPERTY()
+ float DamageMultiplier = 1.0f;
 };
 
 template<>
@@ -42,6 +66,7 @@ struct TStructOpsTypeTraits<FHeroesGameplayEffectContext> : public TStructOpsTyp
 {
  enum
  {
-  WithNetSerializer = true
+  WithNetSerializer = true,
+  WithCopy = true
  };
 };
\ No newline at end of file
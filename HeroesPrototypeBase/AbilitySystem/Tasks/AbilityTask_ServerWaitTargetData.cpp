@@ -4,6 +4,11 @@
 #include "AbilitySystem/Tasks/AbilityTask_ServerWaitTargetData.h"
 
 #include "AbilitySystemComponent.h"
+#include "Abilities/GameplayAbility.h"
+#include "AbilitySystem/Auxiliary/TargetActors/HeroesGATA_Trace.h"
+#include "AbilitySystem/Components/HeroesAbilitySystemComponent.h"
+#include "HeroesGameFramework/HeroesLagCompensationSubsystem.h"
+#include "Inventory/InventoryItemInstance.h"
 #include "Editor.h"
 
 UAbilityTask_ServerWaitTargetData* UAbilityTask_ServerWaitTargetData::ServerWaitForClientTargetData(UGameplayAbility* OwningAbility, FName TaskInstanceName)
@@ -30,6 +35,20 @@ void UAbilityTask_ServerWaitTargetData::OnTargetDataReplicatedCallback(const FGa
 	FGameplayAbilityTargetDataHandle MutableData = Data;
 	AbilitySystemComponent->ConsumeClientReplicatedTargetData(GetAbilitySpecHandle(), GetActivationPredictionKey());
 
+	/* Validate weapon shots with their weapon's target actor, which validates all of a shot's spread and hits in one
+	 * place, even if the target actor also receives this data. Weapon abilities are granted by their weapon. Other
+	 * abilities' hits are only re-verified against the lag-compensated hitboxes of the heroes they hit. */
+	UHeroesAbilitySystemComponent* HeroesASC = Cast<UHeroesAbilitySystemComponent>(AbilitySystemComponent.Get());
+	UInventoryItemInstance* WeaponItem = Cast<UInventoryItemInstance>(Ability->GetCurrentSourceObject());
+	if (AHeroesGATA_Trace* WeaponTargetActor = (HeroesASC && WeaponItem) ? HeroesASC->GetWeaponTargetActor(WeaponItem) : nullptr)
+	{
+		WeaponTargetActor->ValidateReplicatedShot(Ability, MutableData);
+	}
+	else
+	{
+		UHeroesLagCompensationSubsystem::ValidateTargetDataInWorld(GetWorld(), MutableData, Ability->GetAvatarActorFromActorInfo());
+	}
+
 	if (ShouldBroadcastAbilityTaskDelegates())
 	{
 		ValidData.Broadcast(MutableData);
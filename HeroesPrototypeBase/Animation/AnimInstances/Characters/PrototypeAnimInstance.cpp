@@ -238,7 +238,7 @@ FTransform UPrototypeAnimInstance::CalculateHandADSOffset()
 	FName WeaponRootBone = "root";
 	FName AttachSocket = "ik_hand_gun";
 	USkeletalMeshComponent* CharacterMesh = GetSkelMeshComponent();
-	USkeletalMeshComponent* WeaponMesh = EquippedItemEquippableTrait->FirstPersonEquippedActor->FindComponentByClass<USkeletalMeshComponent>();
+	USkeletalMeshComponent* WeaponMesh = UEquippableItemTrait::GetFirstPersonEquippedActor(EquippedItem)->FindComponentByClass<USkeletalMeshComponent>();
 
 	const FTransform AttachedSocketTransform = WeaponMesh->GetSocketTransform(WeaponRootBone, RTS_World);
 	FVector ALoc = FVector();
@@ -258,7 +258,7 @@ FTransform UPrototypeAnimInstance::CalculateHandADSOffset()
 	const FVector E = ALoc - BLoc;
 
 
-	TArray<UActorComponent*> SightComponents = EquippedItemEquippableTrait->FirstPersonEquippedActor->GetComponentsByTag(UMeshComponent::StaticClass(), FName("Sight"));
+	TArray<UActorComponent*> SightComponents = UEquippableItemTrait::GetFirstPersonEquippedActor(EquippedItem)->GetComponentsByTag(UMeshComponent::StaticClass(), FName("Sight"));
 
 	UMeshComponent* SightMesh = SightComponents.Num() > 0 ? Cast<UMeshComponent>(SightComponents[0]) : nullptr;
 
@@ -370,7 +370,7 @@ FTransform UPrototypeAnimInstance::CalculateHandCorrectionOffset()
 	const FName WeaponRootBone = "root";
 	const FName AttachSocket = "ik_hand_gun";
 	const USkeletalMeshComponent* CharacterMesh = GetSkelMeshComponent();
-	const USkeletalMeshComponent* WeaponMesh = EquippedItemEquippableTrait->FirstPersonEquippedActor->FindComponentByClass<USkeletalMeshComponent>();
+	const USkeletalMeshComponent* WeaponMesh = UEquippableItemTrait::GetFirstPersonEquippedActor(EquippedItem)->FindComponentByClass<USkeletalMeshComponent>();
 
 	// Might have to be bone transform, not socket
 	const FTransform SocketTransform = CharacterMesh->GetSocketTransform(AttachSocket, RTS_World);
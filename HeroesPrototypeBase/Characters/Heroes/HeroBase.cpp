@@ -25,6 +25,7 @@
 #include "GameFramework/CharacterMovementComponent.h"
 
 #include "Engine/ActorChannel.h"
+#include "HeroesGameFramework/HeroesLagCompensationSubsystem.h"
 #include "Net/UnrealNetwork.h"
 #include "Player/PlayerStates/Game/HeroesGamePlayerStateBase.h"
 
@@ -96,6 +97,25 @@ AHeroBase::AHeroBase(const FObjectInitializer& ObjectInitializer)
 void AHeroBase::BeginPlay()
 {
 	Super::BeginPlay();
+
+	// Only the server validates hits, so only the server needs to record hitboxes.
+	if (HasAuthority())
+	{
+		if (UHeroesLagCompensationSubsystem* LagCompensationSubsystem = GetWorld()->GetSubsystem<UHeroesLagCompensationSubsystem>())
+		{
+			LagCompensationSubsystem->RegisterHero(this);
+		}
+	}
+}
+
+void AHeroBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UHeroesLagCompensationSubsystem* LagCompensationSubsystem = GetWorld()->GetSubsystem<UHeroesLagCompensationSubsystem>())
+	{
+		LagCompensationSubsystem->UnregisterHero(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void AHeroBase::PossessedBy(AController* NewController)
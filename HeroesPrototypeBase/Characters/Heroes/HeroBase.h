@@ -54,9 +54,13 @@ public:
 
 protected:
 
-	/** Called when the game starts or when spawned. */
+	/** Called when the game starts or when spawned. Starts recording this character's hitbox for lag compensation on
+	 * the server. */
 	virtual void BeginPlay() override;
 
+	/** Stops recording this character's hitbox for lag compensation. */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	/** Performs server-side initialization for the owning player's ASC and grants this character's default ability sets. */
 	virtual void PossessedBy(AController* NewController) override;
 
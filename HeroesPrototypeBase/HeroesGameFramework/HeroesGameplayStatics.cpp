@@ -3,35 +3,76 @@
 
 #include "HeroesGameFramework/HeroesGameplayStatics.h"
 
-bool UHeroesGameplayStatics::CanReachTarget(UWorld* InWorld, FVector StartVector, AActor* Target, TArray<AActor*> ActorsToIgnore)
+#include "Async/ParallelFor.h"
+
+/** Batches with fewer targets than this are tested serially, since it isn't worth dispatching them to other threads. */
+static constexpr int32 ParallelReachTargetThreshold = 4;
+
+/** Checks whether a line-of-sight trace is unobstructed. Traces are tested against simple collision first, and only
+ * against complex collision if simple collision blocks them, since complex collision can have gaps (e.g. windows) that
+ * simple collision doesn't. */
+static bool IsLineOfSightClear(const UWorld* InWorld, const FVector& Start, const FVector& End, const FCollisionQueryParams& SimpleParams, const FCollisionQueryParams& ComplexParams)
 {
-	FCollisionQueryParams CollisionParams = FCollisionQueryParams();
-	CollisionParams.bTraceComplex = true;
-	CollisionParams.AddIgnoredActors(ActorsToIgnore);
+	return !InWorld->LineTraceTestByChannel(Start, End, ECC_Visibility, SimpleParams) ||
+		!InWorld->LineTraceTestByChannel(Start, End, ECC_Visibility, ComplexParams);
+}
 
-	// If the target is a pawn, test line-of-sight to the bottom, middle, and top of their collision cylinder.
-	if (APawn* TargetPawn = Cast<APawn>(Target))
+/** Checks whether a vector can reach a single target, testing as few traces as possible. */
+static bool CanReachTargetInternal(const UWorld* InWorld, const FVector& StartVector, const AActor* Target, const FCollisionQueryParams& SimpleParams, const FCollisionQueryParams& ComplexParams)
+{
+	if (!IsValid(Target))
 	{
-		bool bBottom = false, bMiddle = false, bTop = false;
-
-		float TargetRadius, TargetHalfHeight;
-		TargetPawn->GetSimpleCollisionCylinder(TargetRadius, TargetHalfHeight);
-		
-		const FVector BottomLocation = TargetPawn->GetActorLocation() - FVector(0.0f, 0.0f, TargetHalfHeight);
-		bBottom = !InWorld->LineTraceTestByChannel(StartVector, BottomLocation, ECC_Visibility, CollisionParams);
-		
-		const FVector MiddleLocation = TargetPawn->GetActorLocation();
-		bMiddle = !InWorld->LineTraceTestByChannel(StartVector, MiddleLocation, ECC_Visibility, CollisionParams);
-		
-		const FVector TopLocation = TargetPawn->GetActorLocation() + FVector(0.0f, 0.0f, TargetHalfHeight);
-		bTop = !InWorld->LineTraceTestByChannel(StartVector, TopLocation, ECC_Visibility, CollisionParams);
-
-		// If the vector has line-of-sight to the bottom and middle of the target or the top and middle of the target, it will reach the target.
-		return (bBottom && bMiddle || bTop && bMiddle);
+		return false;
 	}
-	// If the target is not a pawn, do a simple trace to the center of the target to check if the vector will reach it.
-	else
+
+	// The middle of the target is always required, so test it first.
+	const FVector MiddleLocation = Target->GetActorLocation();
+	if (!IsLineOfSightClear(InWorld, StartVector, MiddleLocation, SimpleParams, ComplexParams))
+	{
+		return false;
+	}
+
+	// If the target is not a pawn, the trace to its center is enough to check if the vector will reach it.
+	const APawn* TargetPawn = Cast<APawn>(Target);
+	if (!TargetPawn)
+	{
+		return true;
+	}
+
+	// If the vector has line-of-sight to the bottom and middle of the target or the top and middle of the target, it will reach the target.
+	float TargetRadius, TargetHalfHeight;
+	TargetPawn->GetSimpleCollisionCylinder(TargetRadius, TargetHalfHeight);
+
+	const FVector BottomLocation = MiddleLocation - FVector(0.0f, 0.0f, TargetHalfHeight);
+	const FVector TopLocation = MiddleLocation + FVector(0.0f, 0.0f, TargetHalfHeight);
+	return IsLineOfSightClear(InWorld, StartVector, BottomLocation, SimpleParams, ComplexParams) ||
+		IsLineOfSightClear(InWorld, StartVector, TopLocation, SimpleParams, ComplexParams);
+}
+
+bool UHeroesGameplayStatics::CanReachTarget(UWorld* InWorld, FVector StartVector, AActor* Target, const TArray<AActor*>& ActorsToIgnore)
+{
+	TArray<bool> CanReach;
+	CanReachTargets(InWorld, StartVector, { Target }, ActorsToIgnore, CanReach);
+	return CanReach[0];
+}
+
+void UHeroesGameplayStatics::CanReachTargets(UWorld* InWorld, FVector StartVector, const TArray<AActor*>& Targets, const TArray<AActor*>& ActorsToIgnore, TArray<bool>& OutCanReach)
+{
+	OutCanReach.Init(false, Targets.Num());
+	if (!InWorld)
 	{
-		return !InWorld->LineTraceTestByChannel(StartVector, Target->GetActorLocation(), ECC_Visibility, CollisionParams);
+		return;
 	}
+
+	FCollisionQueryParams SimpleParams(SCENE_QUERY_STAT(CanReachTarget), false);
+	SimpleParams.AddIgnoredActors(ActorsToIgnore);
+
+	FCollisionQueryParams ComplexParams = SimpleParams;
+	ComplexParams.bTraceComplex = true;
+
+	// Scene queries are read-only, so the targets can be tested in parallel; each target writes only to its own result.
+	ParallelFor(Targets.Num(), [&](int32 i)
+	{
+		OutCanReach[i] = CanReachTargetInternal(InWorld, StartVector, Targets[i], SimpleParams, ComplexParams);
+	}, Targets.Num() < ParallelReachTargetThreshold);
 }
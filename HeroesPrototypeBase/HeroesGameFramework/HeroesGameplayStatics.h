@@ -18,5 +18,20 @@ public:
  /** Checks whether a vector can reach a target unobstructed. If the target is a pawn, the vector must have line of
   * sight to its feet and torso, torso and head, or all three if it wants to reach the target. */
  UFUNCTION(BlueprintPure, Category = "Heroes|Utils")
- static bool CanReachTarget(UWorld* InWorld, FVector StartVector, AActor* Target, TArray<AActor*> ActorsToIgnore);
+ static bool CanReachTarget(UWorld* InWorld, FVector StartVector, AActor* Target, const TArray<AActor*>& ActorsToIgnore);
+
+ /**
+  * Checks whether a vector can reach each of the given targets unobstructed, using the same rules as CanReachTarget.
+  * This is much cheaper than calling CanReachTarget for each target: targets are tested in parallel, each target
+  * stops being tested as soon as its result is known, and traces only fall back to complex collision when simple
+  * collision blocks them.
+  *
+  * @param InWorld			The world in which to test line-of-sight.
+  * @param StartVector		The location from which every target is tested.
+  * @param Targets			The targets to test.
+  * @param ActorsToIgnore	Actors that don't block line-of-sight.
+  * @param OutCanReach		Whether each target can be reached, in the same order as Targets.
+  */
+ UFUNCTION(BlueprintPure, Category = "Heroes|Utils")
+ static void CanReachTargets(UWorld* InWorld, FVector StartVector, const TArray<AActor*>& Targets, const TArray<AActor*>& ActorsToIgnore, TArray<bool>& OutCanReach);
 };
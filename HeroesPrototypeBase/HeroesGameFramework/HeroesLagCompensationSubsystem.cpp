@@ -0,0 +1,439 @@
+// Copyright Samuel Reitich 2024.
+
+
+#include "HeroesGameFramework/HeroesLagCompensationSubsystem.h"
+
+#include "AbilitySystemComponent.h"
+#include "AbilitySystemGlobals.h"
+#include "Abilities/GameplayAbilityTargetTypes.h"
+#include "AbilitySystem/HeroesGameplayAbilityTargetTypes.h"
+#include "AbilitySystem/HeroesNativeGameplayTags.h"
+#include "AbilitySystem/Components/HealthComponent.h"
+#include "Characters/Heroes/HeroBase.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/GameStateBase.h"
+#include "HeroesLogChannels.h"
+
+DECLARE_CYCLE_STAT(TEXT("Record Hitboxes"), STAT_RecordHitboxes, STATGROUP_Game);
+DECLARE_CYCLE_STAT(TEXT("Validate Target Data"), STAT_ValidateTargetData, STATGROUP_Game);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Rejected Hits"), STAT_RejectedHits, STATGROUP_Game);
+
+static TAutoConsoleVariable<float> CVarMaxRewindTime
+(
+	TEXT("Heroes.LagCompensation.MaxRewindTime"),
+	0.3f,
+	TEXT("The furthest back in time, in seconds, that the server will rewind hitboxes to validate a client's hit."),
+	ECVF_Default
+);
+
+static TAutoConsoleVariable<float> CVarHitTolerance
+(
+	TEXT("Heroes.LagCompensation.HitTolerance"),
+	30.0f,
+	TEXT("How far outside of a hero's rewound capsule a claimed hit can be and still be accepted. This must account for")
+	TEXT(" parts of the hero's mesh that extend past its capsule."),
+	ECVF_Default
+);
+
+static TAutoConsoleVariable<float> CVarCriticalHitTolerance
+(
+	TEXT("Heroes.LagCompensation.CriticalHitTolerance"),
+	25.0f,
+	TEXT("How far from a hero's rewound critical hit bone a claimed critical hit can be and still be accepted."),
+	ECVF_Default
+);
+
+static TAutoConsoleVariable<float> CVarMaxOriginError
+(
+	TEXT("Heroes.LagCompensation.MaxOriginError"),
+	250.0f,
+	TEXT("How far from the shooter's location on the server a claimed hit's trace can start and still be accepted."),
+	ECVF_Default
+);
+
+bool UHeroesLagCompensationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UHeroesLagCompensationSubsystem::Deinitialize()
+{
+	Histories.Empty();
+	HistoryIndices.Empty();
+
+	Super::Deinitialize();
+}
+
+void UHeroesLagCompensationSubsystem::RegisterHero(AHeroBase* Hero)
+{
+	if (!IsValid(Hero) || HistoryIndices.Contains(Hero))
+	{
+		return;
+	}
+
+	const int32 NewIndex = Histories.AddDefaulted();
+	Histories[NewIndex].Hero = Hero;
+	Histories[NewIndex].HeroKey = Hero;
+	HistoryIndices.Add(Hero, NewIndex);
+}
+
+void UHeroesLagCompensationSubsystem::UnregisterHero(AHeroBase* Hero)
+{
+	int32 Index;
+	if (HistoryIndices.RemoveAndCopyValue(Hero, Index))
+	{
+		RemoveHistoryAt(Index);
+	}
+}
+
+void UHeroesLagCompensationSubsystem::RemoveHistoryAt(int32 Index)
+{
+	Histories.RemoveAtSwap(Index, 1, false);
+
+	// Re-index the history that was swapped into the removed history's place.
+	if (Histories.IsValidIndex(Index))
+	{
+		HistoryIndices.Add(Histories[Index].HeroKey, Index);
+	}
+}
+
+bool UHeroesLagCompensationSubsystem::ValidateTargetData(FGameplayAbilityTargetDataHandle& TargetData, const AActor* Shooter) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ValidateTargetData);
+
+	const double CurrentTime = GetServerTime();
+	bool bAllHitsAccepted = true;
+
+	for (TSharedPtr<FGameplayAbilityTargetData>& Data : TargetData.Data)
+	{
+		if (!Data.IsValid())
+		{
+			continue;
+		}
+
+		const UScriptStruct* DataType = Data->GetScriptStruct();
+
+		// Multi-pellet shots store every pellet's hit in a single entry.
+		if (DataType->IsChildOf(FHeroesGameplayAbilityTargetData_PelletHits::StaticStruct()))
+		{
+			FHeroesGameplayAbilityTargetData_PelletHits* PelletData = static_cast<FHeroesGameplayAbilityTargetData_PelletHits*>(Data.Get());
+
+			for (FHeroesPelletHit& PelletHit : PelletData->Hits)
+			{
+				// Only hits on heroes are validated.
+				const AHeroBase* HitHero = Cast<AHeroBase>(PelletHit.Actor.Get());
+				if (!HitHero)
+				{
+					continue;
+				}
+
+				// Pellet hits are stored where they hit, so their trace is validated up to their impact point.
+				const FName ClaimedBoneName = PelletHit.BoneName;
+				if (!ValidateHeroHit(HitHero, PelletData->TraceStart, PelletHit.ImpactPoint, PelletHit.ImpactPoint, PelletHit.BoneName, PelletData->ShotTime, Shooter))
+				{
+					PelletHit.Actor = nullptr;
+					PelletHit.BoneName = NAME_None;
+					bAllHitsAccepted = false;
+				}
+				else if (PelletHit.BoneName != ClaimedBoneName)
+				{
+					bAllHitsAccepted = false;
+				}
+			}
+
+			continue;
+		}
+
+		if (!DataType->IsChildOf(FGameplayAbilityTargetData_SingleTargetHit::StaticStruct()))
+		{
+			continue;
+		}
+
+		FHitResult& Hit = static_cast<FGameplayAbilityTargetData_SingleTargetHit*>(Data.Get())->HitResult;
+
+		// Only hits on heroes are validated.
+		const AHeroBase* HitHero = Cast<AHeroBase>(Hit.GetActor());
+		if (!HitHero)
+		{
+			continue;
+		}
+
+		// Hits without a timestamp are validated against the heroes' current hitboxes.
+		double ShotTime = CurrentTime;
+		if (DataType->IsChildOf(FHeroesGameplayAbilityTargetData_SingleTargetHit::StaticStruct()))
+		{
+			ShotTime = static_cast<FHeroesGameplayAbilityTargetData_SingleTargetHit*>(Data.Get())->ShotTime;
+		}
+
+		const FName ClaimedBoneName = Hit.BoneName;
+		if (!ValidateHeroHit(HitHero, Hit.TraceStart, Hit.TraceEnd, Hit.ImpactPoint, Hit.BoneName, ShotTime, Shooter))
+		{
+			ConvertHitToMiss(Hit);
+			bAllHitsAccepted = false;
+		}
+		else if (Hit.BoneName != ClaimedBoneName)
+		{
+			bAllHitsAccepted = false;
+		}
+	}
+
+	return bAllHitsAccepted;
+}
+
+bool UHeroesLagCompensationSubsystem::ValidateHeroHit(const AHeroBase* HitHero, const FVector& TraceStart, const FVector& TraceEnd, const FVector& ImpactPoint, FName& InOutBoneName, double ShotTime, const AActor* Shooter) const
+{
+	const float HitTolerance = CVarHitTolerance.GetValueOnGameThread();
+
+	/* The trace must start near the shooter, and the hit must be on the trace. Otherwise, the client could claim hits
+	 * from anywhere. */
+	bool bHitValid = !Shooter || FVector::DistSquared(TraceStart, Shooter->GetActorLocation()) <= FMath::Square(CVarMaxOriginError.GetValueOnGameThread());
+	bHitValid = bHitValid && FMath::PointDistToSegmentSquared(ImpactPoint, TraceStart, TraceEnd) <= FMath::Square(HitTolerance);
+
+	FHeroesHitboxSnapshot Hitbox;
+	const bool bRewound = bHitValid && RewindHitbox(HitHero, ShotTime, Hitbox);
+	if (bRewound)
+	{
+		// The hit must be within the rewound capsule, which is the segment between its hemispheres' centers, inflated by its radius.
+		const FVector CapsuleOffset = FVector(0.0f, 0.0f, FMath::Max(0.0f, Hitbox.CapsuleHalfHeight - Hitbox.CapsuleRadius));
+		const float CapsuleDistance = FMath::PointDistToSegment(ImpactPoint, Hitbox.CapsuleLocation - CapsuleOffset, Hitbox.CapsuleLocation + CapsuleOffset) - Hitbox.CapsuleRadius;
+		bHitValid = CapsuleDistance <= HitTolerance;
+	}
+
+	if (!bHitValid)
+	{
+		UE_LOG(LogHeroesAbilitySystem, Verbose, TEXT("Rejected hit on %s claimed by %s."), *GetNameSafe(HitHero), *GetNameSafe(Shooter));
+		INC_DWORD_STAT(STAT_RejectedHits);
+		return false;
+	}
+
+	// Hits on bones that aren't critical hit bones aren't critical hits, so they don't need to be validated.
+	const UHealthComponent* HealthComponent = HitHero->GetHealthComponent();
+	if (InOutBoneName.IsNone() || !HealthComponent || !HealthComponent->bHasCriticalHitPoint)
+	{
+		return true;
+	}
+
+	const int32 CriticalHitBoneIndex = HealthComponent->CriticalHitBones.IndexOfByPredicate([&InOutBoneName](const FName& CriticalHitBone)
+	{
+		return CriticalHitBone.IsEqual(InOutBoneName, ENameCase::IgnoreCase);
+	});
+
+	if (CriticalHitBoneIndex == INDEX_NONE)
+	{
+		return true;
+	}
+
+	/* Critical hits must be near the rewound critical hit bone that they claim to have hit. Critical hits that can't be
+	 * checked against a recorded bone (e.g. because the hero's hitbox isn't recorded) are downgraded. */
+	const bool bCriticalHitValid = bRewound &&
+		Hitbox.CriticalHitBoneLocations.IsValidIndex(CriticalHitBoneIndex) &&
+		FVector::DistSquared(ImpactPoint, Hitbox.CriticalHitBoneLocations[CriticalHitBoneIndex]) <= FMath::Square(CVarCriticalHitTolerance.GetValueOnGameThread());
+
+	if (!bCriticalHitValid)
+	{
+		UE_LOG(LogHeroesAbilitySystem, Verbose, TEXT("Rejected critical hit on %s claimed by %s."), *GetNameSafe(HitHero), *GetNameSafe(Shooter));
+		INC_DWORD_STAT(STAT_RejectedHits);
+		InOutBoneName = NAME_None;
+	}
+
+	return true;
+}
+
+bool UHeroesLagCompensationSubsystem::ValidateTargetDataInWorld(const UWorld* World, FGameplayAbilityTargetDataHandle& TargetData, const AActor* Shooter)
+{
+	const UHeroesLagCompensationSubsystem* LagCompensationSubsystem = World ? World->GetSubsystem<UHeroesLagCompensationSubsystem>() : nullptr;
+	return !LagCompensationSubsystem || LagCompensationSubsystem->ValidateTargetData(TargetData, Shooter);
+}
+
+void UHeroesLagCompensationSubsystem::ConvertHitToMiss(FHitResult& Hit)
+{
+	Hit.HitObjectHandle = FActorInstanceHandle();
+	Hit.Component = nullptr;
+	Hit.BoneName = NAME_None;
+	Hit.bBlockingHit = false;
+}
+
+bool UHeroesLagCompensationSubsystem::RewindHitbox(const AHeroBase* Hero, double Time, FHeroesHitboxSnapshot& OutHitbox) const
+{
+	const int32* HistoryIndex = HistoryIndices.Find(Hero);
+	if (!HistoryIndex)
+	{
+		return false;
+	}
+
+	const FHeroesHitboxHistory& History = Histories[*HistoryIndex];
+	if (History.Num == 0)
+	{
+		return false;
+	}
+
+	// Clients can't rewind further than the maximum rewind time, or into the future.
+	const double CurrentTime = GetServerTime();
+	Time = FMath::Clamp(Time, CurrentTime - CVarMaxRewindTime.GetValueOnGameThread(), CurrentTime);
+
+	const FHeroesHitboxSnapshot& Newest = History.GetRecent(0);
+	const FHeroesHitboxSnapshot& Oldest = History.GetRecent(History.Num - 1);
+
+	if (Time >= Newest.Timestamp)
+	{
+		OutHitbox = Newest;
+		return true;
+	}
+
+	if (Time <= Oldest.Timestamp)
+	{
+		OutHitbox = Oldest;
+		return true;
+	}
+
+	// Snapshots get older as their age increases, so binary search for the newest snapshot at or before the given time.
+	int32 Low = 1;
+	int32 High = History.Num - 1;
+	while (Low < High)
+	{
+		const int32 Middle = (Low + High) / 2;
+		if (History.GetRecent(Middle).Timestamp <= Time)
+		{
+			High = Middle;
+		}
+		else
+		{
+			Low = Middle + 1;
+		}
+	}
+
+	// Interpolate between the snapshots on either side of the given time.
+	const FHeroesHitboxSnapshot& Before = History.GetRecent(Low);
+	const FHeroesHitboxSnapshot& After = History.GetRecent(Low - 1);
+	const float Alpha = (After.Timestamp > Before.Timestamp) ? (float)((Time - Before.Timestamp) / (After.Timestamp - Before.Timestamp)) : 1.0f;
+
+	OutHitbox.Timestamp = Time;
+	OutHitbox.CapsuleLocation = FMath::Lerp(Before.CapsuleLocation, After.CapsuleLocation, Alpha);
+	OutHitbox.CapsuleRadius = FMath::Lerp(Before.CapsuleRadius, After.CapsuleRadius, Alpha);
+	OutHitbox.CapsuleHalfHeight = FMath::Lerp(Before.CapsuleHalfHeight, After.CapsuleHalfHeight, Alpha);
+	OutHitbox.CriticalHitBoneLocations.SetNumUninitialized(FMath::Min(Before.CriticalHitBoneLocations.Num(), After.CriticalHitBoneLocations.Num()));
+
+	for (int32 BoneIndex = 0; BoneIndex < OutHitbox.CriticalHitBoneLocations.Num(); ++BoneIndex)
+	{
+		OutHitbox.CriticalHitBoneLocations[BoneIndex] = FMath::Lerp(Before.CriticalHitBoneLocations[BoneIndex], After.CriticalHitBoneLocations[BoneIndex], Alpha);
+	}
+
+	// Aims aren't interpolated, since a hero's aim can't be between two recorded aims if it snapped between them.
+	OutHitbox.Aim = (Alpha < 0.5f) ? Before.Aim : After.Aim;
+
+	return true;
+}
+
+bool UHeroesLagCompensationSubsystem::GetAimStatesSince(const AHeroBase* Hero, double Time, TArray<FHeroesAimState, TInlineAllocator<16>>& OutAimStates) const
+{
+	const int32* HistoryIndex = HistoryIndices.Find(Hero);
+	if (!HistoryIndex)
+	{
+		return false;
+	}
+
+	const FHeroesHitboxHistory& History = Histories[*HistoryIndex];
+	if (History.Num == 0)
+	{
+		return false;
+	}
+
+	// Clients can't rewind further than the maximum rewind time.
+	const double CurrentTime = GetServerTime();
+	Time = FMath::Max(Time, CurrentTime - CVarMaxRewindTime.GetValueOnGameThread());
+
+	// Gather snapshots from newest to oldest, stopping after the newest snapshot at or before the given time.
+	for (int32 Age = 0; Age < History.Num; ++Age)
+	{
+		const FHeroesHitboxSnapshot& Snapshot = History.GetRecent(Age);
+		OutAimStates.Add(Snapshot.Aim);
+
+		if (Snapshot.Timestamp <= Time)
+		{
+			break;
+		}
+	}
+
+	return true;
+}
+
+double UHeroesLagCompensationSubsystem::GetServerTime() const
+{
+	const UWorld* World = GetWorld();
+	const AGameStateBase* GameState = World->GetGameState();
+
+	/* Clients timestamp their shots with their estimate of the server's time. This estimate trails the server by
+	 * roughly half of the client's latency, which is also roughly how far behind the client's view of other heroes is. */
+	return GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+}
+
+void UHeroesLagCompensationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SCOPE_CYCLE_COUNTER(STAT_RecordHitboxes);
+
+	const double CurrentTime = GetServerTime();
+
+	for (int32 i = Histories.Num() - 1; i >= 0; --i)
+	{
+		FHeroesHitboxHistory& History = Histories[i];
+
+		// Heroes unregister themselves when they end play, but may be destroyed without ending play (e.g. in the editor).
+		const AHeroBase* Hero = History.Hero.Get();
+		if (!Hero)
+		{
+			HistoryIndices.Remove(History.HeroKey);
+			RemoveHistoryAt(i);
+			continue;
+		}
+
+		FHeroesHitboxSnapshot& Snapshot = History.Snapshots[History.Head];
+		RecordHitbox(Hero, Snapshot);
+		Snapshot.Timestamp = CurrentTime;
+
+		History.Head = (History.Head + 1) % FHeroesHitboxHistory::Capacity;
+		History.Num = FMath::Min(History.Num + 1, FHeroesHitboxHistory::Capacity);
+	}
+}
+
+bool UHeroesLagCompensationSubsystem::IsTickable() const
+{
+	const UWorld* World = GetWorld();
+	return World && World->GetNetMode() != NM_Client && !IsTemplate() && Histories.Num() > 0;
+}
+
+TStatId UHeroesLagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHeroesLagCompensationSubsystem, STATGROUP_Tickables);
+}
+
+void UHeroesLagCompensationSubsystem::RecordHitbox(const AHeroBase* Hero, FHeroesHitboxSnapshot& OutSnapshot)
+{
+	const UCapsuleComponent* Capsule = Hero->GetCapsuleComponent();
+	OutSnapshot.CapsuleLocation = Capsule->GetComponentLocation();
+	OutSnapshot.CapsuleRadius = Capsule->GetScaledCapsuleRadius();
+	OutSnapshot.CapsuleHalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+	OutSnapshot.CriticalHitBoneLocations.Reset();
+
+	OutSnapshot.Aim.AimRotation = Hero->GetControlRotation();
+	const UAbilitySystemComponent* ASC = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Hero);
+	OutSnapshot.Aim.bAiming = ASC && ASC->HasMatchingGameplayTag(FHeroesNativeGameplayTags::Get().State_Aiming);
+
+	/* Critical hit bones are only accurate on the server if the critical hit mesh keeps its bones refreshed when it
+	 * isn't rendered (see VisibilityBasedAnimTickOption). */
+	const UHealthComponent* HealthComponent = Hero->GetHealthComponent();
+	if (!HealthComponent || !HealthComponent->bHasCriticalHitPoint || !IsValid(HealthComponent->CriticalHitMesh))
+	{
+		return;
+	}
+
+	// Every critical hit bone is recorded, so every critical hit can be validated. Snapshots are re-used, so this only allocates the first time a hero with many bones is recorded.
+	const int32 NumBones = HealthComponent->CriticalHitBones.Num();
+	OutSnapshot.CriticalHitBoneLocations.SetNumUninitialized(NumBones, false);
+	for (int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex)
+	{
+		OutSnapshot.CriticalHitBoneLocations[BoneIndex] = HealthComponent->CriticalHitMesh->GetSocketLocation(HealthComponent->CriticalHitBones[BoneIndex]);
+	}
+}
@@ -0,0 +1,194 @@
+// Copyright Samuel Reitich 2024.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HeroesLagCompensationSubsystem.generated.h"
+
+class AHeroBase;
+struct FGameplayAbilityTargetDataHandle;
+
+/**
+ * Where a hero was aiming at a single point in time.
+ */
+struct FHeroesAimState
+{
+	FRotator AimRotation = FRotator::ZeroRotator;
+
+	/** Whether the hero was aiming down their sights, which affects their weapon's spread. */
+	bool bAiming = false;
+};
+
+/**
+ * The hitbox and aim of a hero at a single point in time.
+ */
+struct FHeroesHitboxSnapshot
+{
+	/** The number of critical hit bones stored without allocating. Heroes usually only have one. */
+	static constexpr int32 InlineCriticalHitBones = 2;
+
+	/** The server world time at which this snapshot was recorded. */
+	double Timestamp = 0.0;
+
+	/** The world location of the hero's capsule. Characters' capsules are always upright, so they don't need a
+	 * rotation. */
+	FVector CapsuleLocation = FVector::ZeroVector;
+
+	float CapsuleRadius = 0.0f;
+
+	float CapsuleHalfHeight = 0.0f;
+
+	/** The world locations of every one of the hero's critical hit bones, in the order of the health component's
+	 * CriticalHitBones. Sized from the hero's critical hit bones each time it's recorded. */
+	TArray<FVector, TInlineAllocator<InlineCriticalHitBones>> CriticalHitBoneLocations;
+
+	/** The hero's aim. Used to validate the direction of the hero's own shots. */
+	FHeroesAimState Aim;
+};
+
+/**
+ * The recent hitbox snapshots of a single hero, stored in a fixed-size ring buffer.
+ */
+struct FHeroesHitboxHistory
+{
+	/** The number of snapshots kept for each hero. This must cover the maximum rewind time at the server's tick rate. */
+	static constexpr int32 Capacity = 64;
+
+	TWeakObjectPtr<AHeroBase> Hero;
+
+	/** The hero's key in the subsystem's history indices. Kept separately so the history can be removed if the hero is
+	 * destroyed without unregistering. */
+	const AHeroBase* HeroKey = nullptr;
+
+	FHeroesHitboxSnapshot Snapshots[Capacity];
+
+	/** The index at which the next snapshot will be written. */
+	int32 Head = 0;
+
+	/** The number of valid snapshots. */
+	int32 Num = 0;
+
+	/** Returns the snapshot recorded the given number of snapshots ago, where 0 is the newest snapshot. */
+	const FHeroesHitboxSnapshot& GetRecent(int32 Age) const
+	{
+		return Snapshots[(Head - 1 - Age + Capacity) % Capacity];
+	}
+};
+
+/**
+ * Lag compensation for hit-scan weapons. The server records a snapshot of every hero's hitbox (their capsule and
+ * critical hit bones) each tick. When a client claims a hit, the server rewinds the hit hero's hitbox to the time at
+ * which the client fired and re-verifies the hit against it.
+ *
+ * Hits on heroes that can't be verified are converted into misses, and critical hits that can't be verified against a
+ * recorded critical hit bone are downgraded to normal hits. Hits on anything other than a hero are not validated.
+ */
+UCLASS()
+class HEROESPROTOTYPEBASE_API UHeroesLagCompensationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	// Subsystem.
+
+public:
+
+	/** Lag compensation is only needed in game worlds. */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	virtual void Deinitialize() override;
+
+
+
+	// Hero registration.
+
+public:
+
+	/** Starts recording the given hero's hitbox. Heroes register themselves on the server when they begin play. */
+	void RegisterHero(AHeroBase* Hero);
+
+	/** Stops recording the given hero's hitbox. */
+	void UnregisterHero(AHeroBase* Hero);
+
+private:
+
+	/** Removes the history at the given index. Does not remove the history's hero from HistoryIndices. */
+	void RemoveHistoryAt(int32 Index);
+
+	/** The hitbox history of every registered hero. */
+	TArray<FHeroesHitboxHistory> Histories;
+
+	/** Maps each registered hero to the index of its history, so hits can find their hero's history quickly. */
+	TMap<const AHeroBase*, int32> HistoryIndices;
+
+
+
+	// Validation.
+
+public:
+
+	/**
+	 * Re-verifies every hit in the given target data against the hitboxes of the hit heroes at the time each hit was
+	 * claimed. Invalid hits are converted into misses and invalid critical hits are downgraded, so the target data can
+	 * still be used for cosmetics.
+	 *
+	 * @param TargetData		The target data to validate. Modified in-place.
+	 * @param Shooter			The actor that produced the target data. Used to verify the hits' trace origins.
+	 * @return					True if every hit was accepted as-is.
+	 */
+	bool ValidateTargetData(FGameplayAbilityTargetDataHandle& TargetData, const AActor* Shooter) const;
+
+	/** Validates the given target data using the world's lag compensation subsystem, if it has one. */
+	static bool ValidateTargetDataInWorld(const UWorld* World, FGameplayAbilityTargetDataHandle& TargetData, const AActor* Shooter);
+
+	/** Strips the hit actor from the given hit, so it's treated as a miss. The hit's locations are kept for cosmetics. */
+	static void ConvertHitToMiss(FHitResult& Hit);
+
+	/** Returns the given hero's hitbox at the given server world time, interpolated between the two nearest
+	 * snapshots. The time is clamped to the maximum rewind time. Returns false if the hero's hitbox isn't recorded. */
+	bool RewindHitbox(const AHeroBase* Hero, double Time, FHeroesHitboxSnapshot& OutHitbox) const;
+
+	/**
+	 * Gathers every aim recorded for the given hero from the given server world time until now, including the aim the
+	 * hero had at that time. The time is clamped to the maximum rewind time.
+	 *
+	 * A hero's aim reaches the server with their movement, which can arrive after their shots. Shots should be
+	 * validated against every aim the hero could have had when they fired, rather than their aim at a single time.
+	 *
+	 * @return					False if the hero's aim isn't recorded.
+	 */
+	bool GetAimStatesSince(const AHeroBase* Hero, double Time, TArray<FHeroesAimState, TInlineAllocator<16>>& OutAimStates) const;
+
+private:
+
+	/**
+	 * Validates a single claimed hit on the given hero against its rewound hitbox.
+	 *
+	 * @param InOutBoneName		The bone claimed by the hit. Cleared if the hit is valid but its critical hit isn't, or
+	 *							if its critical hit can't be checked against a recorded bone.
+	 * @return					False if the hit is invalid and should be converted into a miss.
+	 */
+	bool ValidateHeroHit(const AHeroBase* HitHero, const FVector& TraceStart, const FVector& TraceEnd, const FVector& ImpactPoint, FName& InOutBoneName, double ShotTime, const AActor* Shooter) const;
+
+	/** Returns the current server world time. */
+	double GetServerTime() const;
+
+
+
+	// Recording.
+
+public:
+
+	/** Records a snapshot of every registered hero's hitbox and aim. */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Only the server ticks this subsystem, since only the server validates hits. */
+	virtual bool IsTickable() const override;
+
+	virtual TStatId GetStatId() const override;
+
+private:
+
+	/** Writes the given hero's current hitbox and aim into the given snapshot. */
+	static void RecordHitbox(const AHeroBase* Hero, FHeroesHitboxSnapshot& OutSnapshot);
+};
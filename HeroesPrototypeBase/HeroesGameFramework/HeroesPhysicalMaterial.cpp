@@ -0,0 +1,4 @@
+// Copyright Samuel Reitich 2024.
+
+
+#include "HeroesGameFramework/HeroesPhysicalMaterial.h"
@@ -0,0 +1,29 @@
+// Copyright Samuel Reitich 2024.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "HeroesPhysicalMaterial.generated.h"
+
+/**
+ * A physical material that defines how shots penetrate surfaces made of it. Surfaces that don't use this material
+ * are penetrated with this class's default values.
+ */
+UCLASS()
+class HEROESPROTOTYPEBASE_API UHeroesPhysicalMaterial : public UPhysicalMaterial
+{
+	GENERATED_BODY()
+
+public:
+
+	/** How much of a shot's penetration budget is spent passing through this surface. See
+	 * UWeaponStaticDataAsset::PenetrationBudget. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Penetration", meta = (ClampMin = 0))
+	float PenetrationCost = 1.0f;
+
+	/** The damage of shots that pass through this surface is multiplied by this value for everything they hit
+	 * afterwards. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Penetration", meta = (ClampMin = 0, ClampMax = 1))
+	float PenetrationDamageMultiplier = 1.0f;
+};
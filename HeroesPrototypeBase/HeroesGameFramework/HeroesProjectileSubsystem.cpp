@@ -0,0 +1,328 @@
+// Copyright Samuel Reitich 2024.
+
+
+#include "HeroesGameFramework/HeroesProjectileSubsystem.h"
+
+#include "AbilitySystem/Auxiliary/ProjectileExtensionComponent.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Batched Projectiles"), STAT_BatchedProjectiles, STATGROUP_Game);
+DECLARE_CYCLE_STAT(TEXT("Batched Projectile Simulation"), STAT_BatchedProjectileSimulation, STATGROUP_Game);
+
+static TAutoConsoleVariable<bool> CVarBatchedProjectiles
+(
+	TEXT("Heroes.Projectiles.BatchedSimulation"),
+	true,
+	TEXT("Whether simple projectiles are simulated in a batch by the projectile subsystem instead of ticking their own")
+	TEXT(" movement. Only affects projectiles spawned after it's changed."),
+	ECVF_Default
+);
+
+static TAutoConsoleVariable<float> CVarPredictedProjectileTimeout
+(
+	TEXT("Heroes.Projectiles.PredictedProjectileTimeout"),
+	1.0f,
+	TEXT("How long, in seconds, a client's predicted projectile waits to be adopted by the server's projectile before")
+	TEXT(" it's destroyed."),
+	ECVF_Default
+);
+
+/** Steps with fewer projectiles than this are swept serially, since it isn't worth dispatching them to other threads. */
+static constexpr int32 ParallelProjectileSweepThreshold = 8;
+
+void FHeroesProjectileBuffer::RemoveAtSwap(int32 Index)
+{
+	Components.RemoveAtSwap(Index, 1, false);
+	Locations.RemoveAtSwap(Index, 1, false);
+	Rotations.RemoveAtSwap(Index, 1, false);
+	Velocities.RemoveAtSwap(Index, 1, false);
+	GravityZ.RemoveAtSwap(Index, 1, false);
+	MaxSpeeds.RemoveAtSwap(Index, 1, false);
+	CollisionShapes.RemoveAtSwap(Index, 1, false);
+	CollisionChannels.RemoveAtSwap(Index, 1, false);
+	QueryParams.RemoveAtSwap(Index, 1, false);
+	ResponseParams.RemoveAtSwap(Index, 1, false);
+}
+
+bool UHeroesProjectileSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+bool UHeroesProjectileSubsystem::RegisterProjectile(UProjectileExtensionComponent* ProjectileComponent)
+{
+	UPrimitiveComponent* UpdatedPrimitive = ProjectileComponent ? ProjectileComponent->UpdatedPrimitive.Get() : nullptr;
+	if (!UpdatedPrimitive || !CVarBatchedProjectiles.GetValueOnGameThread())
+	{
+		return false;
+	}
+
+	if (Projectiles.Components.Contains(ProjectileComponent))
+	{
+		return true;
+	}
+
+	Projectiles.Components.Add(ProjectileComponent);
+	Projectiles.Locations.Add(UpdatedPrimitive->GetComponentLocation());
+	Projectiles.Rotations.Add(UpdatedPrimitive->GetComponentQuat());
+	Projectiles.Velocities.Add(ProjectileComponent->Velocity);
+	Projectiles.GravityZ.Add(ProjectileComponent->GetGravityZ());
+	Projectiles.MaxSpeeds.Add(ProjectileComponent->GetMaxSpeed());
+	Projectiles.CollisionShapes.Add(UpdatedPrimitive->GetCollisionShape());
+	Projectiles.CollisionChannels.Add(UpdatedPrimitive->GetCollisionObjectType());
+
+	// Sweep with the same parameters the projectile would use to move itself (e.g. ignoring its instigator).
+	FCollisionQueryParams& QueryParams = Projectiles.QueryParams.Emplace_GetRef(SCENE_QUERY_STAT(BatchedProjectileSweep), false, UpdatedPrimitive->GetOwner());
+	FCollisionResponseParams& ResponseParams = Projectiles.ResponseParams.AddDefaulted_GetRef();
+	UpdatedPrimitive->InitSweepCollisionParams(QueryParams, ResponseParams);
+
+	INC_DWORD_STAT(STAT_BatchedProjectiles);
+
+	return true;
+}
+
+void UHeroesProjectileSubsystem::UnregisterProjectile(UProjectileExtensionComponent* ProjectileComponent)
+{
+	// Projectiles can be unregistered while the simulation is handing them their hits, so they're only cleared here.
+	const int32 Index = Projectiles.Components.IndexOfByKey(ProjectileComponent);
+	if (Index != INDEX_NONE)
+	{
+		Projectiles.Components[Index] = nullptr;
+	}
+}
+
+void UHeroesProjectileSubsystem::RemoveInactiveProjectiles()
+{
+	for (int32 i = Projectiles.Num() - 1; i >= 0; --i)
+	{
+		// Projectiles that have left the world are destroyed or stopped by CheckStillInWorld, like they would be by their own tick.
+		UProjectileExtensionComponent* ProjectileComponent = Projectiles.Components[i].Get();
+		if (!ProjectileComponent || !ProjectileComponent->IsActive() || !ProjectileComponent->UpdatedComponent || !ProjectileComponent->CheckStillInWorld())
+		{
+			Projectiles.RemoveAtSwap(i);
+			DEC_DWORD_STAT(STAT_BatchedProjectiles);
+		}
+	}
+}
+
+void UHeroesProjectileSubsystem::RegisterPredictedProjectile(UProjectileExtensionComponent* PredictedProjectile)
+{
+	if (!IsValid(PredictedProjectile) || !PredictedProjectile->GetPredictionKey().IsValidKey())
+	{
+		return;
+	}
+
+	FHeroesPredictedProjectile& Predicted = PredictedProjectiles.AddDefaulted_GetRef();
+	Predicted.Projectile = PredictedProjectile;
+	Predicted.PredictionKey = PredictedProjectile->GetPredictionKey().Current;
+	Predicted.SpawnTime = GetWorld()->GetTimeSeconds();
+
+	// If the server rejects the ability that spawned this projectile, the server's projectile will never arrive.
+	FPredictionKey PredictionKey = PredictedProjectile->GetPredictionKey();
+	PredictionKey.NewRejectedDelegate().BindWeakLambda(PredictedProjectile, [PredictedProjectile]()
+	{
+		PredictedProjectile->GetOwner()->Destroy();
+	});
+}
+
+bool UHeroesProjectileSubsystem::AdoptPredictedProjectile(UProjectileExtensionComponent* AuthoritativeProjectile)
+{
+	if (!IsValid(AuthoritativeProjectile) || !AuthoritativeProjectile->GetPredictionKey().IsValidKey())
+	{
+		return false;
+	}
+
+	const int16 PredictionKey = AuthoritativeProjectile->GetPredictionKey().Current;
+	const UClass* ProjectileClass = AuthoritativeProjectile->GetOwner()->GetClass();
+
+	for (int32 i = 0; i < PredictedProjectiles.Num(); ++i)
+	{
+		UProjectileExtensionComponent* PredictedProjectile = PredictedProjectiles[i].Projectile.Get();
+		if (!PredictedProjectile || PredictedProjectiles[i].PredictionKey != PredictionKey || PredictedProjectile->GetOwner()->GetClass() != ProjectileClass)
+		{
+			continue;
+		}
+
+		/* The server's projectile arrives where it was spawned, behind the predicted projectile by however long the
+		 * predicted projectile has been flying. Catch it up first, so only the remaining error has to be blended out. */
+		const float PredictionDelay = FMath::Min(GetWorld()->GetTimeSeconds() - PredictedProjectiles[i].SpawnTime, CVarPredictedProjectileTimeout.GetValueOnGameThread());
+		AuthoritativeProjectile->CatchUpToPrediction(PredictionDelay);
+
+		// Keep the remaining projectiles in order, so projectiles sharing a prediction key are matched in spawn order.
+		PredictedProjectiles.RemoveAt(i, 1, false);
+
+		if (AuthoritativeProjectile->StartPredictionCorrection(PredictedProjectile))
+		{
+			CorrectingProjectiles.AddUnique(AuthoritativeProjectile);
+		}
+
+		PredictedProjectile->GetOwner()->Destroy();
+
+		return true;
+	}
+
+	return false;
+}
+
+void UHeroesProjectileSubsystem::UpdatePredictedProjectiles(float DeltaTime)
+{
+	// Predicted projectiles are ordered by spawn time, so stop at the first one that hasn't timed out.
+	const double TimeoutTime = GetWorld()->GetTimeSeconds() - CVarPredictedProjectileTimeout.GetValueOnGameThread();
+	int32 NumExpired = 0;
+	for (; NumExpired < PredictedProjectiles.Num(); ++NumExpired)
+	{
+		const FHeroesPredictedProjectile& Predicted = PredictedProjectiles[NumExpired];
+		UProjectileExtensionComponent* PredictedProjectile = Predicted.Projectile.Get();
+		if (PredictedProjectile && Predicted.SpawnTime > TimeoutTime)
+		{
+			break;
+		}
+
+		if (PredictedProjectile)
+		{
+			PredictedProjectile->GetOwner()->Destroy();
+		}
+	}
+
+	if (NumExpired > 0)
+	{
+		PredictedProjectiles.RemoveAt(0, NumExpired, false);
+	}
+
+	for (int32 i = CorrectingProjectiles.Num() - 1; i >= 0; --i)
+	{
+		UProjectileExtensionComponent* ProjectileComponent = CorrectingProjectiles[i].Get();
+		if (!ProjectileComponent || !ProjectileComponent->UpdatePredictionCorrection(DeltaTime))
+		{
+			CorrectingProjectiles.RemoveAtSwap(i, 1, false);
+		}
+	}
+}
+
+void UHeroesProjectileSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_BatchedProjectileSimulation);
+
+	Super::Tick(DeltaTime);
+
+	UpdatePredictedProjectiles(DeltaTime);
+
+	RemoveInactiveProjectiles();
+
+	const int32 NumProjectiles = Projectiles.Num();
+	if (NumProjectiles == 0 || DeltaTime <= 0.0f)
+	{
+		return;
+	}
+
+	// Gather each projectile's current state, since it can be changed outside of the simulation (e.g. by replication).
+	Projectiles.Accelerations.SetNumUninitialized(NumProjectiles, false);
+
+	for (int32 i = 0; i < NumProjectiles; ++i)
+	{
+		UProjectileExtensionComponent* ProjectileComponent = Projectiles.Components[i].Get();
+		Projectiles.Locations[i] = ProjectileComponent->UpdatedComponent->GetComponentLocation();
+		Projectiles.Rotations[i] = ProjectileComponent->UpdatedComponent->GetComponentQuat();
+		Projectiles.Velocities[i] = ProjectileComponent->Velocity;
+
+		// Forces added to the projectile since its last step are applied for this step only, like the movement component does.
+		Projectiles.Accelerations[i] = FVector(0.0f, 0.0f, Projectiles.GravityZ[i]) + ProjectileComponent->GetPendingForce();
+		ProjectileComponent->ClearPendingForce(true);
+	}
+
+	// Integrate every projectile's velocity the same way the projectile movement component does.
+	Projectiles.NewVelocities.SetNumUninitialized(NumProjectiles, false);
+	Projectiles.MoveDeltas.SetNumUninitialized(NumProjectiles, false);
+
+	for (int32 i = 0; i < NumProjectiles; ++i)
+	{
+		const FVector& OldVelocity = Projectiles.Velocities[i];
+		const FVector& Acceleration = Projectiles.Accelerations[i];
+		FVector NewVelocity = OldVelocity + Acceleration * DeltaTime;
+
+		const float MaxSpeed = Projectiles.MaxSpeeds[i];
+		if (MaxSpeed > 0.0f)
+		{
+			NewVelocity = NewVelocity.GetClampedToMaxSize(MaxSpeed);
+		}
+
+		Projectiles.NewVelocities[i] = NewVelocity;
+		Projectiles.MoveDeltas[i] = (OldVelocity * DeltaTime) + (Acceleration * (0.5f * DeltaTime * DeltaTime));
+	}
+
+	/* Sweep every projectile as a batch. Scene queries are read-only, so the projectiles can be swept in parallel; each
+	 * projectile writes only to its own hit. */
+	UWorld* World = GetWorld();
+	Projectiles.Hits.SetNum(NumProjectiles, false);
+
+	ParallelFor(NumProjectiles, [&](int32 i)
+	{
+		const FVector& Start = Projectiles.Locations[i];
+		Projectiles.Hits[i] = FHitResult();
+		World->SweepSingleByChannel(Projectiles.Hits[i], Start, Start + Projectiles.MoveDeltas[i], Projectiles.Rotations[i], Projectiles.CollisionChannels[i], Projectiles.CollisionShapes[i], Projectiles.QueryParams[i], Projectiles.ResponseParams[i]);
+	}, NumProjectiles < ParallelProjectileSweepThreshold);
+
+	/* Apply the results. Projectiles can be unregistered, and new projectiles registered, while their hits are handled,
+	 * so projectiles are only accessed by index and only the projectiles that were swept are updated. */
+	for (int32 i = 0; i < NumProjectiles; ++i)
+	{
+		UProjectileExtensionComponent* ProjectileComponent = Projectiles.Components[i].Get();
+		if (!ProjectileComponent || !ProjectileComponent->UpdatedComponent)
+		{
+			continue;
+		}
+
+		FHitResult& Hit = Projectiles.Hits[i];
+		const FVector& MoveDelta = Projectiles.MoveDeltas[i];
+		const FVector NewVelocity = Projectiles.NewVelocities[i];
+
+		FQuat NewRotation = Projectiles.Rotations[i];
+		if (ProjectileComponent->bRotationFollowsVelocity && !NewVelocity.IsNearlyZero())
+		{
+			FRotator DesiredRotation = NewVelocity.Rotation();
+			if (ProjectileComponent->bRotationRemainsVertical)
+			{
+				DesiredRotation.Pitch = 0.0f;
+				DesiredRotation.Yaw = FRotator::NormalizeAxis(DesiredRotation.Yaw);
+				DesiredRotation.Roll = 0.0f;
+			}
+
+			NewRotation = DesiredRotation.Quaternion();
+		}
+
+		ProjectileComponent->Velocity = NewVelocity;
+
+		// Projectiles that start inside geometry move themselves, so the movement component can push them out of it.
+		if (Hit.bStartPenetrating)
+		{
+			ProjectileComponent->SafeMoveUpdatedComponent(MoveDelta, NewRotation, true, Hit);
+		}
+		else
+		{
+			if (Hit.bBlockingHit)
+			{
+				UProjectileExtensionComponent::PullBackHit(Hit, MoveDelta.Size());
+			}
+
+			const FVector NewLocation = Projectiles.Locations[i] + (Hit.bBlockingHit ? MoveDelta * Hit.Time : MoveDelta);
+			ProjectileComponent->UpdatedComponent->SetWorldLocationAndRotation(NewLocation, NewRotation);
+		}
+
+		ProjectileComponent->UpdateComponentVelocity();
+
+		if (Hit.bBlockingHit && ProjectileComponent->UpdatedComponent)
+		{
+			ProjectileComponent->HandleBatchedHit(Hit, DeltaTime, MoveDelta * Hit.Time);
+		}
+	}
+}
+
+bool UHeroesProjectileSubsystem::IsTickable() const
+{
+	return (Projectiles.Num() > 0 || PredictedProjectiles.Num() > 0 || CorrectingProjectiles.Num() > 0) && !IsTemplate();
+}
+
+TStatId UHeroesProjectileSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHeroesProjectileSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,168 @@
+// Copyright Samuel Reitich 2024.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CollisionQueryParams.h"
+#include "CollisionShape.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HeroesProjectileSubsystem.generated.h"
+
+class UProjectileExtensionComponent;
+
+/**
+ * The state of every projectile simulated by the projectile subsystem, stored as a structure of arrays. Each
+ * projectile's state is at the same index of every array.
+ */
+struct FHeroesProjectileBuffer
+{
+	/** The movement component of each projectile. Cleared when a projectile is unregistered; cleared entries are
+	 * removed at the start of the next simulation step. */
+	TArray<TWeakObjectPtr<UProjectileExtensionComponent>> Components;
+
+	TArray<FVector> Locations;
+
+	TArray<FQuat> Rotations;
+
+	TArray<FVector> Velocities;
+
+	/** The gravity applied to each projectile, including its gravity scale. */
+	TArray<float> GravityZ;
+
+	/** The maximum speed of each projectile. 0 means no limit. */
+	TArray<float> MaxSpeeds;
+
+	/** The collision of each projectile's updated component, captured when it was registered. */
+	TArray<FCollisionShape> CollisionShapes;
+	TArray<TEnumAsByte<ECollisionChannel>> CollisionChannels;
+	TArray<FCollisionQueryParams> QueryParams;
+	TArray<FCollisionResponseParams> ResponseParams;
+
+	/** Scratch space for each simulation step: each projectile's acceleration (including the forces added to it since
+	 * the last step), its velocity and movement at the end of the step, and its sweep's blocking hit. */
+	TArray<FVector> Accelerations;
+	TArray<FVector> NewVelocities;
+	TArray<FVector> MoveDeltas;
+	TArray<FHitResult> Hits;
+
+	int32 Num() const { return Components.Num(); }
+
+	/** Removes the projectile at the given index by swapping the last projectile into its place. */
+	void RemoveAtSwap(int32 Index);
+};
+
+/**
+ * A cosmetic projectile spawned by a predicting client, waiting for the server's projectile to adopt it.
+ */
+struct FHeroesPredictedProjectile
+{
+	TWeakObjectPtr<UProjectileExtensionComponent> Projectile;
+
+	/** The prediction key of the ability that spawned the projectile. */
+	int16 PredictionKey = 0;
+
+	/** The world time at which the projectile was spawned. Predicted projectiles that aren't adopted in time are
+	 * destroyed. */
+	double SpawnTime = 0.0;
+};
+
+/**
+ * Simulates the movement of every simple projectile in a world in a single batch, instead of each projectile's movement
+ * component ticking on its own. Each step, every projectile's velocity is integrated, all of their sweeps are performed
+ * together (in parallel, when there are enough of them), and the results are applied to the projectiles.
+ *
+ * Only projectiles that stop when they hit something are simulated here; bouncing projectiles tick their own movement.
+ * Blocking hits are handed back to each projectile's movement component, which dispatches them and stops the projectile
+ * exactly as it would if it had moved itself. See UProjectileExtensionComponent::HandleBatchedHit.
+ *
+ * This subsystem also reconciles predicted projectiles on clients. When the server's projectile reaches the client
+ * that predicted it, it adopts the client's cosmetic projectile: the server's projectile is moved forward by the
+ * cosmetic projectile's age, to catch up to where the cosmetic projectile is, and the cosmetic projectile is destroyed.
+ * Any remaining difference between them is blended out of the server's projectile's visuals over a short time. See
+ * UHeroesGameplayAbilityBase::SpawnPredictedProjectile.
+ */
+UCLASS()
+class HEROESPROTOTYPEBASE_API UHeroesProjectileSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	// Subsystem.
+
+public:
+
+	/** Projectiles only exist in game worlds. */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+
+
+	// Projectile registration.
+
+public:
+
+	/** Starts simulating the given projectile's movement. The projectile's movement component should stop ticking on its
+	 * own. Returns false if batched simulation is disabled, in which case the projectile must keep ticking itself. */
+	bool RegisterProjectile(UProjectileExtensionComponent* ProjectileComponent);
+
+	/** Stops simulating the given projectile's movement. */
+	void UnregisterProjectile(UProjectileExtensionComponent* ProjectileComponent);
+
+private:
+
+	/** Every projectile being simulated. */
+	FHeroesProjectileBuffer Projectiles;
+
+
+
+	// Predicted projectiles.
+
+public:
+
+	/** Starts tracking the given cosmetic projectile, spawned by this client to predict a projectile spawned by the
+	 * server. Predicted projectiles register themselves when they begin play. */
+	void RegisterPredictedProjectile(UProjectileExtensionComponent* PredictedProjectile);
+
+	/**
+	 * Replaces the cosmetic projectile predicted for the given server projectile, if this client predicted one. The
+	 * server's projectile is moved forward by the time since the predicted projectile was spawned, the predicted
+	 * projectile is destroyed, and the server's projectile's visuals are blended from the predicted projectile's
+	 * location to its own.
+	 *
+	 * Multiple projectiles of the same class spawned with the same prediction key are adopted in the order they were
+	 * spawned.
+	 *
+	 * @return					True if a predicted projectile was adopted.
+	 */
+	bool AdoptPredictedProjectile(UProjectileExtensionComponent* AuthoritativeProjectile);
+
+private:
+
+	/** Destroys predicted projectiles that were never adopted, and advances the visual corrections of adopted
+	 * projectiles. */
+	void UpdatePredictedProjectiles(float DeltaTime);
+
+	/** Predicted projectiles waiting to be adopted, ordered from oldest to newest. */
+	TArray<FHeroesPredictedProjectile> PredictedProjectiles;
+
+	/** Server projectiles whose visuals are still being blended from the predicted projectile they adopted. */
+	TArray<TWeakObjectPtr<UProjectileExtensionComponent>> CorrectingProjectiles;
+
+
+
+	// Simulation.
+
+public:
+
+	/** Advances every registered projectile and updates predicted projectiles. */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Only ticks while there are projectiles to simulate or reconcile. */
+	virtual bool IsTickable() const override;
+
+	virtual TStatId GetStatId() const override;
+
+private:
+
+	/** Removes projectiles that have been unregistered, destroyed, that have stopped simulating, or that have left the
+	 * world. */
+	void RemoveInactiveProjectiles();
+};
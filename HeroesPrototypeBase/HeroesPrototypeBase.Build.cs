@@ -15,7 +15,8 @@ public class HeroesPrototypeBase : ModuleRules
 			"Engine",
 			"InputCore",
 			"EnhancedInput",
-			"NetCore"
+			"NetCore",
+			"StructUtils"
 		});
 		
 		PublicIncludePaths.Add("HeroesPrototypeBase/");
@@ -24,9 +25,13 @@ public class HeroesPrototypeBase : ModuleRules
 		{
 			"GameplayAbilities",
 			"GameplayTags",
-			"GameplayTasks"
+			"GameplayTasks",
+			"PhysicsCore"
 		});
 
+		// Uncomment to record shot telemetry, which can be dumped with the "Heroes.Weapons.DumpShotTelemetry" command
+		// PublicDefinitions.Add("HEROES_SHOT_TELEMETRY=1");
+
 		// Uncomment if you are using Slate UI
 		// PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
 		
@@ -5,6 +5,32 @@
 
 #include "HeroesLogChannels.h"
 
+void FGameplayTagStackContainer::PreReplicatedRemove(const TArrayView<int32>& RemovedIndices, int32 FinalSize)
+{
+	for (const int32 Index : RemovedIndices)
+	{
+		StackMap.Remove(Stacks[Index].Tag);
+	}
+}
+
+void FGameplayTagStackContainer::PostReplicatedAdd(const TArrayView<int32>& AddedIndices, int32 FinalSize)
+{
+	for (const int32 Index : AddedIndices)
+	{
+		const FGameplayTagStack& Stack = Stacks[Index];
+		StackMap.Add(Stack.Tag, Stack.Quantity);
+	}
+}
+
+void FGameplayTagStackContainer::PostReplicatedChange(const TArrayView<int32>& ChangedIndices, int32 FinalSize)
+{
+	for (const int32 Index : ChangedIndices)
+	{
+		const FGameplayTagStack& Stack = Stacks[Index];
+		StackMap.Add(Stack.Tag, Stack.Quantity);
+	}
+}
+
 void FGameplayTagStackContainer::AddTags(FGameplayTag Tag, int32 Quantity)
 {
 	// Ensure the given tag is valid.
@@ -17,27 +43,25 @@ void FGameplayTagStackContainer::AddTags(FGameplayTag Tag, int32 Quantity)
 	// Ignore requests to add less than 1 tag.
 	if (Quantity > 0)
 	{
-		// Search the stack array for a stack of the given tag.
-		for (FGameplayTagStack& Stack : Stacks)
+		// If this container has a stack of the given tag, add the given quantity to it and its corresponding map entry.
+		if (const int32* StackIndex = StackIndices.Find(Tag))
 		{
-			// If this container has a stack of the given tag, add the given quantity to it and its corresponding map entry.
-			if (Stack.Tag == Tag)
-			{
-				const int32 NewQuantity = Stack.Quantity + Quantity;
-				Stack.Quantity = NewQuantity;
-				MarkItemDirty(Stack);
+			FGameplayTagStack& Stack = Stacks[*StackIndex];
+			const int32 NewQuantity = Stack.Quantity + Quantity;
+			Stack.Quantity = NewQuantity;
+			MarkItemDirty(Stack);
 
-				StackMap[Tag] = NewQuantity;
+			StackMap[Tag] = NewQuantity;
 
-				return;
-			}
+			return;
 		}
 
 		// If this container doesn't have a stack of the given tag, create one.
-		FGameplayTagStack& NewStack = Stacks.Emplace_GetRef(Tag, Quantity);
-		MarkItemDirty(NewStack);
+		const int32 NewIndex = Stacks.Emplace(Tag, Quantity);
+		MarkItemDirty(Stacks[NewIndex]);
 
 		StackMap.Add(Tag, Quantity);
+		StackIndices.Add(Tag, NewIndex);
 	}
 }
 
@@ -53,43 +77,49 @@ void FGameplayTagStackContainer::RemoveTags(FGameplayTag Tag, int32 Quantity)
 	// Ignore requests to remove less than 1 tag.
 	if (Quantity > 0)
 	{
-		// Search the stack array for a stack of the given tag.
-		for (auto It = Stacks.CreateIterator(); It; ++It)
+		// Find the stack of the given tag.
+		const int32* StackIndexPtr = StackIndices.Find(Tag);
+		if (!StackIndexPtr)
 		{
-			FGameplayTagStack& Stack = *It;
-			if (Stack.Tag == Tag)
+			return;
+		}
+
+		const int32 StackIndex = *StackIndexPtr;
+		FGameplayTagStack& Stack = Stacks[StackIndex];
+		const int32 NewQuantity = Stack.Quantity - Quantity;
+
+		// If all of the tags will be removed, remove the stack from the array and the maps.
+		if (NewQuantity < 1)
+		{
+			// Swap the last stack into the removed stack's place so no other stacks have to be moved.
+			Stacks.RemoveAtSwap(StackIndex, 1, false);
+			MarkArrayDirty();
+
+			StackMap.Remove(Tag);
+			StackIndices.Remove(Tag);
+
+			if (Stacks.IsValidIndex(StackIndex))
 			{
-				const int32 NewQuantity = Stack.Quantity - Quantity;
-			
-				// If all of the tags will be removed, remove the stack from the array and the map.
-				if (NewQuantity < 1)
-				{
-					It.RemoveCurrent();
-					MarkArrayDirty();
-
-					StackMap.Remove(Tag);
-				}
-				// If there will still at least 1 tag in the stack, update the stack and the map.
-				else
-				{
-					Stack.Quantity = NewQuantity;
-					MarkItemDirty(Stack);
-
-					StackMap[Tag] = NewQuantity;
-				}
-			
-				return;
+				StackIndices[Stacks[StackIndex].Tag] = StackIndex;
 			}
 		}
+		// If there will still at least 1 tag in the stack, update the stack and the map.
+		else
+		{
+			Stack.Quantity = NewQuantity;
+			MarkItemDirty(Stack);
+
+			StackMap[Tag] = NewQuantity;
+		}
 	}
 }
 
 int32 FGameplayTagStackContainer::GetTagCount(FGameplayTag Tag) const
 {
 	// Use the stack map for fast queries.
-	if (StackMap.Contains(Tag))
+	if (const int32* Quantity = StackMap.Find(Tag))
 	{
-		return StackMap[Tag];
+		return *Quantity;
 	}
 
 	return 0;
@@ -66,6 +66,15 @@ public:
 		return FFastArraySerializer::FastArrayDeltaSerialize<FGameplayTagStack, FGameplayTagStackContainer>(Stacks, DeltaParams, *this);
 	}
 
+	/** Removes stacks from @StackMap on clients before they are removed from @Stacks. */
+	void PreReplicatedRemove(const TArrayView<int32>& RemovedIndices, int32 FinalSize);
+
+	/** Adds new stacks to @StackMap on clients. */
+	void PostReplicatedAdd(const TArrayView<int32>& AddedIndices, int32 FinalSize);
+
+	/** Updates the quantities of changed stacks in @StackMap on clients. */
+	void PostReplicatedChange(const TArrayView<int32>& ChangedIndices, int32 FinalSize);
+
 
 
 	// Tag stack handling.
@@ -102,8 +111,14 @@ private:
 	UPROPERTY()
 	TArray<FGameplayTagStack> Stacks;
 
-	/** A map that mirrors @Stacks. Use this instead of @Stacks when speed is prioritized, e.g. for queries. */
+	/** A map that mirrors @Stacks, mapping each tag to its quantity. Use this instead of @Stacks when speed is
+	 * prioritized, e.g. for queries. This is maintained by the server when stacks are changed, and by clients when
+	 * stacks are replicated. */
 	TMap<FGameplayTag, int32> StackMap;
+
+	/** Maps each tag to the index of its stack in @Stacks. Used to modify stacks without searching for them. Only
+	 * maintained by the server, since clients' stacks are modified by replication. */
+	TMap<FGameplayTag, int32> StackIndices;
 };
 
 /**
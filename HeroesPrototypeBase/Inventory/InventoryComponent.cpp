@@ -9,18 +9,29 @@
 #include "InventoryItemDefinition.h"
 #include "InventoryItemInstance.h"
 #include "InventoryItemPickupActor.h"
+#include "InventoryItemPickupSubsystem.h"
+#include "AbilitySystem/HeroesAbilitySystemGlobals.h"
+#include "AbilitySystem/Components/HeroesAbilitySystemComponent.h"
 #include "Animation/AnimInstances/Characters/HeroFirstPersonAnimInstance.h"
 #include "Animation/AnimInstances/Characters/PrototypeAnimInstanceV3.h"
 #include "Camera/CameraComponent.h"
 #include "Characters/Components/FirstPersonSkeletalMeshComponent.h"
 #include "Characters/Heroes/HeroBase.h"
 #include "Components/CapsuleComponent.h"
-#include "Engine/ActorChannel.h"
+#include "GameFramework/PlayerController.h"
 #include "ItemTraits/DroppableItemTrait.h"
 #include "ItemTraits/EquippableItemTrait.h"
 #include "Net/UnrealNetwork.h"
 #include "Player/PlayerStates/Game/HeroesGamePlayerStateBase.h"
 
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Equipment Actors"), STAT_PooledEquipmentActors, STATGROUP_HeroesInventory);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Equipment Actors Spawned"), STAT_EquipmentActorsSpawned, STATGROUP_HeroesInventory);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Equipment Actors Reused"), STAT_EquipmentActorsReused, STATGROUP_HeroesInventory);
+
+/** Where parked equipment actors are moved, outside of the playable space. This is above the default kill Z, so parked
+ * actors aren't destroyed for falling out of the world. */
+static const FVector ParkedEquipmentActorLocation = FVector(0.0f, 0.0f, -500000.0f);
+
 UE_DEFINE_GAMEPLAY_TAG_COMMENT(TAG_State_TemporarilyUnarmed, "State.TemporarilyUnarmed", "The player temporarily has no item equipped. When this tag is removed, the item that was previously equipped will be automatically re-equipped. Used for action-blocking abilities.");
 
 static TAutoConsoleVariable<int32> CVarShowInventory
@@ -38,6 +49,9 @@ UInventoryComponent::UInventoryComponent()
 	PrimaryComponentTick.bCanEverTick = true;
 	bWantsInitializeComponent = true;
 	SetIsReplicatedByDefault(true);
+
+	// Items are replicated with per-item conditions using the registered sub-object list.
+	bReplicateUsingRegisteredSubObjectList = true;
 }
 	
 void UInventoryComponent::InitializeComponent()
@@ -55,22 +69,51 @@ void UInventoryComponent::InitializeComponent()
 	}
 }
 
-bool UInventoryComponent::ReplicateSubobjects(UActorChannel* Channel, FOutBunch* Bunch, FReplicationFlags* RepFlags)
+void UInventoryComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Destroy any equipment actors that are still waiting in this inventory's pools.
+	for (TPair<TSubclassOf<UInventoryItemDefinition>, FEquipmentActorPool>& Pool : EquipmentActorPools)
+	{
+		for (AActor* PooledActor : Pool.Value.InactiveActors)
+		{
+			if (IsValid(PooledActor))
+			{
+				PooledActor->Destroy();
+				DEC_DWORD_STAT(STAT_PooledEquipmentActors);
+			}
+		}
+	}
+
+	EquipmentActorPools.Empty();
+	ParkedEquipmentActors.Empty();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UInventoryComponent::ReadyForReplication()
 {
-	bool bWroteSomething = Super::ReplicateSubobjects(Channel, Bunch, RepFlags);
+	Super::ReadyForReplication();
 
-	// Set up proper replication of this inventory's items.
+	// Register any items that were added before this component could replicate.
 	for (FInventoryListEntry& Entry : Inventory.Entries)
 	{
-		UInventoryItemInstance* Item = Entry.Item;
-
-		if (IsValid(Item))
+		if (IsValid(Entry.Item))
 		{
-			bWroteSomething |= Channel->ReplicateSubobject(Item, *Bunch, *RepFlags);
+			UpdateItemReplication(Entry.Item);
 		}
 	}
+}
+
+void UInventoryComponent::UpdateItemReplication(UInventoryItemInstance* Item)
+{
+	if (!IsUsingRegisteredSubObjectList() || !IsReadyForReplication())
+	{
+		return;
+	}
 
-	return bWroteSomething;
+	// Re-register the item to change its condition. Only the owner needs the stats of items that aren't equipped.
+	RemoveReplicatedSubObject(Item);
+	AddReplicatedSubObject(Item, (Item == CurrentlyEquippedItem) ? COND_None : COND_OwnerOnly);
 }
 
 void UInventoryComponent::AddItemHard(UInventoryItemInstance* ItemToAdd, bool bDestroyReplacedItem)
@@ -145,6 +188,7 @@ void UInventoryComponent::AddItem_Internal(UInventoryItemInstance* ItemToAdd)
 
 	// Add the given item to this inventory.
 	Inventory.AddEntry(ItemToAdd);
+	UpdateItemReplication(ItemToAdd);
 
 	// Add the given item to its assigned slot if it's slotted.
 	AddItemToSlot(ItemToAdd);
@@ -161,8 +205,12 @@ void UInventoryComponent::AddItem_Internal(UInventoryItemInstance* ItemToAdd)
 		Trait->OnItemEnteredInventory(ItemToAdd);
 	}
 
-	// If this is the first and only item in this inventory, try to auto-equip it.
-	if (Inventory.Entries.Num() == 1)
+	// If this is the first and only item in this inventory, try to auto-equip it. Batches equip an item when committed.
+	if (IsBatchingItems())
+	{
+		bAutoEquipOnCommit = true;
+	}
+	else if (Inventory.Entries.Num() == 1)
 	{
 		TryEquipItem(ItemToAdd);
 	}
@@ -222,10 +270,13 @@ EInventoryActionResult UInventoryComponent::TryDropItem(UInventoryItemInstance*
 			const FRotator SpawnRotation = HeroCamera->GetComponentRotation();
 			const FTransform SpawnTransform = FTransform(SpawnRotation, SpawnLocation);
 
-			// Spawn and initialize a new item actor to represent the dropped item.
-			AInventoryItemPickupActor* ItemActor = GetWorld()->SpawnActorDeferred<AInventoryItemPickupActor>(DroppableItemTrait->ActorToDrop, SpawnTransform, nullptr, Hero, ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn);
-			ItemActor->Init(ItemToDrop);
-			ItemActor->FinishSpawning(SpawnTransform);
+			// Place an item actor to represent the dropped item, re-using a pooled one if possible.
+			UInventoryItemPickupSubsystem* PickupSubsystem = GetWorld()->GetSubsystem<UInventoryItemPickupSubsystem>();
+			AInventoryItemPickupActor* ItemActor = PickupSubsystem ? PickupSubsystem->SpawnPickup(DroppableItemTrait->ActorToDrop, SpawnTransform, ItemToDrop, Hero) : nullptr;
+			if (!ItemActor)
+			{
+				return EInventoryActionResult::Fail;
+			}
 
 			// Match the item's initial velocity to the velocity of the player that is dropping it.
 			ItemActor->GetRootMesh()->SetAllPhysicsLinearVelocity(Hero->GetVelocity());
@@ -259,51 +310,105 @@ void UInventoryComponent::RemoveItem_Internal(UInventoryItemInstance* ItemToRemo
 		return;
 	}
 
-	// If the item that was removed was currently equipped, unequip it and try to equip another item.
+	/* If the item that was removed was currently equipped, unequip it. It's cleared as the equipped item right away, so
+	 * equipping the next item doesn't unequip it again. */
+	bool bEquipNextItem = false;
 	if (ItemToRemove == CurrentlyEquippedItem)
 	{
 		if (UEquippableItemTrait* EquippableItemTrait = CurrentlyEquippedItem->GetItemDefinition()->FindTraitByClass<UEquippableItemTrait>())
 		{
 			EquippableItemTrait->OnUnequipped(CurrentlyEquippedItem);
+			SetCurrentlyEquippedItem(nullptr);
 
-			// If another item could not be equipped, revert to the "unarmed" character animation data.
-			if (!TryEquipNextItem())
+			// Batches equip another item when committed.
+			if (IsBatchingItems())
 			{
-				CurrentlyEquippedItem = nullptr;
-
-				const APlayerState* PS = GetOwner<APlayerState>();
-				const AHeroBase* Hero = PS->GetPawn<AHeroBase>();
-
-				// TODO: Replace this when creating the final class.
-				if (UPrototypeAnimInstanceV3* FPPAnimInstance = Cast<UPrototypeAnimInstanceV3>(Hero->GetFirstPersonMesh()->GetAnimInstance()))
-				{
-					FPPAnimInstance->UpdateCharacterAnimationData(FPPAnimInstance->DefaultCharacterAnimationData);
-				}
+				bAutoEquipOnCommit = true;
+			}
+			else
+			{
+				bEquipNextItem = true;
 			}
 		}
 	}
 
-	// Add the given item to this inventory.
+	// Remove the given item from this inventory.
 	Inventory.RemoveEntry(ItemToRemove);
+	RemoveReplicatedSubObject(ItemToRemove);
 
 	// Remove the given item from its assigned slot if it's slotted.
 	RemoveItemFromSlot(ItemToRemove);
 
+	// Uninitialize each of the removed item's traits from this inventory before its owner is cleared.
+	for (UInventoryItemTraitBase* Trait : ItemToRemove->GetItemDefinition()->GetTraits())
+	{
+		Trait->OnItemLeftInventory(ItemToRemove);
+	}
+
 	// Clear the item's owner.
 	if (AHeroesGamePlayerStateBase* OwningPlayerState = GetOwner<AHeroesGamePlayerStateBase>())
 	{
 		ItemToRemove->SetCurrentOwner(nullptr);
 	}
 
-	// Uninitialize each of the removed item's traits from this inventory.
-	for (UInventoryItemTraitBase* Trait : ItemToRemove->GetItemDefinition()->GetTraits())
+	// Try to equip another item once the removed item is gone, so it can't be re-equipped. If another item could not be equipped, revert to the "unarmed" character animation data.
+	if (bEquipNextItem && !TryEquipNextItem())
 	{
-		Trait->OnItemLeftInventory(ItemToRemove);
+		ApplyUnarmedAnimationData();
 	}
 
 	// Update the UI.
 }
 
+void UInventoryComponent::BeginItemBatch()
+{
+	// Only the server can add and remove items from a player's inventory.
+	if (!GetOwner()->HasAuthority())
+	{
+		return;
+	}
+
+	// Start deferring replication when the outermost batch begins.
+	if (ItemBatchDepth++ == 0)
+	{
+		Inventory.BeginDeferredDirty();
+	}
+}
+
+void UInventoryComponent::CommitItemBatch()
+{
+	// Only the server can add and remove items from a player's inventory.
+	if (!GetOwner()->HasAuthority())
+	{
+		return;
+	}
+
+	if (!ensureMsgf(ItemBatchDepth > 0, TEXT("CommitItemBatch was called on [%s] without a matching call to BeginItemBatch."), *GetNameSafe(GetOwner())))
+	{
+		return;
+	}
+
+	// Nested batches are committed with the outermost batch.
+	if (--ItemBatchDepth > 0)
+	{
+		return;
+	}
+
+	// Replicate every change made during the batch at once.
+	Inventory.EndDeferredDirty();
+
+	// Equip the highest-priority item if items were added, or the equipped item was removed, during the batch.
+	if (bAutoEquipOnCommit)
+	{
+		bAutoEquipOnCommit = false;
+
+		if (!CurrentlyEquippedItem && !TryEquipNextItem())
+		{
+			ApplyUnarmedAnimationData();
+		}
+	}
+}
+
 EInventoryActionResult UInventoryComponent::TryEquipItem(UInventoryItemInstance* ItemToEquip)
 {
 	// Only the server can equip items from a player's inventory.
@@ -334,7 +439,7 @@ EInventoryActionResult UInventoryComponent::TryEquipItem(UInventoryItemInstance*
 			}
 
 			// Equip the new item.
-			CurrentlyEquippedItem = ItemToEquip;
+			SetCurrentlyEquippedItem(ItemToEquip);
 			EquippableItemTrait->OnEquipped(ItemToEquip);
 
 			return EInventoryActionResult::Success;
@@ -355,7 +460,7 @@ bool UInventoryComponent::TryEquipNextItem()
 	}
 
 	// Try to equip every item that this player has, excluding their currently equipped one, until one is successfully equipped.
-	for (UInventoryItemInstance* Item : GetAllItemsOrdered())
+	for (UInventoryItemInstance* Item : Inventory.GetOrderedItems())
 	{
 		if (Item != CurrentlyEquippedItem)
 		{
@@ -383,12 +488,65 @@ EInventoryActionResult UInventoryComponent::TryUnequipDirect()
 	if (UEquippableItemTrait* EquippableItemTrait = CurrentlyEquippedItem->GetItemDefinition()->FindTraitByClass<UEquippableItemTrait>())
 	{
 		EquippableItemTrait->OnUnequipped(CurrentlyEquippedItem);
-		CurrentlyEquippedItem = nullptr;
+		SetCurrentlyEquippedItem(nullptr);
 	}
 
 	return EInventoryActionResult::Success;
 }
 
+void UInventoryComponent::SetCurrentlyEquippedItem(UInventoryItemInstance* NewEquippedItem)
+{
+	UInventoryItemInstance* OldEquippedItem = CurrentlyEquippedItem;
+	CurrentlyEquippedItem = NewEquippedItem;
+
+	// Only the equipped item is replicated to every connection.
+	if (OldEquippedItem != NewEquippedItem)
+	{
+		if (OldEquippedItem && IsItemInInventory(OldEquippedItem))
+		{
+			UpdateItemReplication(OldEquippedItem);
+		}
+
+		if (NewEquippedItem)
+		{
+			UpdateItemReplication(NewEquippedItem);
+		}
+	}
+}
+
+void UInventoryComponent::OnRep_CurrentlyEquippedItem()
+{
+	const APlayerState* PS = GetOwner<APlayerState>();
+	const APlayerController* PC = PS ? PS->GetPlayerController() : nullptr;
+	if (!CurrentlyEquippedItem || !PC || !PC->IsLocalController())
+	{
+		return;
+	}
+
+	// Spawn and configure weapons' target actors now, so they don't have to be when the weapon is first fired.
+	if (UHeroesAbilitySystemComponent* HeroesASC = UHeroesAbilitySystemGlobals::GetHeroesAbilitySystemComponentFromActor(GetOwner()))
+	{
+		HeroesASC->GetWeaponTargetActor(CurrentlyEquippedItem);
+	}
+}
+
+void UInventoryComponent::ApplyUnarmedAnimationData()
+{
+	const APlayerState* PS = GetOwner<APlayerState>();
+	const AHeroBase* Hero = PS ? PS->GetPawn<AHeroBase>() : nullptr;
+
+	if (!Hero)
+	{
+		return;
+	}
+
+	// TODO: Replace this when creating the final class.
+	if (UPrototypeAnimInstanceV3* FPPAnimInstance = Cast<UPrototypeAnimInstanceV3>(Hero->GetFirstPersonMesh()->GetAnimInstance()))
+	{
+		FPPAnimInstance->UpdateCharacterAnimationData(FPPAnimInstance->DefaultCharacterAnimationData);
+	}
+}
+
 void UInventoryComponent::OnTempUnarmedStateChanged(const FGameplayTag Callback, int32 NewCount)
 {
 	// Only the server should handle this event.
@@ -427,68 +585,212 @@ void UInventoryComponent::OnTempUnarmedStateChanged(const FGameplayTag Callback,
 	}
 }
 
-TArray<UInventoryItemInstance*> UInventoryComponent::GetAllItems(TSubclassOf<UInventoryItemDefinition> FilterByClass)
+void UInventoryComponent::PrewarmEquipmentActors(TSubclassOf<UInventoryItemDefinition> ItemDefinition, TSubclassOf<AActor> ActorClass, int32 Count)
 {
-	// Convert the inventory list entries into an array of pointers to each of their item instances.
-	TArray<UInventoryItemInstance*> OutItems;
-	for (FInventoryListEntry& Entry : Inventory.Entries)
+	// Only the server spawns equipment actors.
+	if (!GetOwner()->HasAuthority() || !ActorClass)
 	{
-		if (Entry.Item)
+		return;
+	}
+
+	FEquipmentActorPool& Pool = EquipmentActorPools.FindOrAdd(ItemDefinition);
+	for (int32 i = 0; i < Count; ++i)
+	{
+		if (AActor* NewActor = SpawnEquipmentActor(ActorClass))
 		{
-			// If we aren't filtering by an item definition, return every item in the inventory.
-			if (FilterByClass == nullptr)
-			{
-				OutItems.Add(Entry.Item);
-			}
-			// If we are filtering by an item definition, only return items with the specified item definition class.
-			else if (Entry.Item->GetItemDefinition()->IsA(FilterByClass))
+			Pool.InactiveActors.Add(NewActor);
+			INC_DWORD_STAT(STAT_PooledEquipmentActors);
+		}
+	}
+}
+
+void UInventoryComponent::TrimEquipmentActors(TSubclassOf<UInventoryItemDefinition> ItemDefinition, int32 Count)
+{
+	FEquipmentActorPool* Pool = EquipmentActorPools.Find(ItemDefinition);
+	if (!Pool)
+	{
+		return;
+	}
+
+	for (int32 i = 0; i < Count && Pool->InactiveActors.Num() > 0; ++i)
+	{
+		if (AActor* PooledActor = Pool->InactiveActors.Pop(false))
+		{
+			ParkedEquipmentActors.RemoveSingleSwap(PooledActor, false);
+			PooledActor->Destroy();
+			DEC_DWORD_STAT(STAT_PooledEquipmentActors);
+		}
+	}
+
+	if (Pool->InactiveActors.Num() == 0)
+	{
+		EquipmentActorPools.Remove(ItemDefinition);
+	}
+}
+
+AActor* UInventoryComponent::AcquireEquipmentActor(TSubclassOf<UInventoryItemDefinition> ItemDefinition, TSubclassOf<AActor> ActorClass)
+{
+	// Re-use a pooled actor if one is available.
+	if (FEquipmentActorPool* Pool = EquipmentActorPools.Find(ItemDefinition))
+	{
+		while (Pool->InactiveActors.Num() > 0)
+		{
+			AActor* PooledActor = Pool->InactiveActors.Pop(false);
+			DEC_DWORD_STAT(STAT_PooledEquipmentActors);
+
+			// Pooled actors can be destroyed externally (e.g. by a level transition).
+			if (IsValid(PooledActor))
 			{
-				OutItems.Add(Entry.Item);
+				SetEquipmentActorParked(PooledActor, false);
+				INC_DWORD_STAT(STAT_EquipmentActorsReused);
+
+				return PooledActor;
 			}
 		}
 	}
 
-	return OutItems;
+	// Spawn a new actor if the pool is empty.
+	AActor* NewActor = SpawnEquipmentActor(ActorClass);
+	if (NewActor)
+	{
+		SetEquipmentActorParked(NewActor, false);
+	}
+
+	return NewActor;
 }
 
-TArray<UInventoryItemInstance*> UInventoryComponent::GetAllItemsOrdered()
+void UInventoryComponent::ReleaseEquipmentActor(TSubclassOf<UInventoryItemDefinition> ItemDefinition, AActor* EquipmentActor)
 {
-	// Create an array into which items will be sorted.
-	TArray<UInventoryItemInstance*> OutItems;
+	if (!IsValid(EquipmentActor))
+	{
+		return;
+	}
+
+	// Deactivate the actor instead of destroying it.
+	SetEquipmentActorParked(EquipmentActor, true);
+
+	EquipmentActorPools.FindOrAdd(ItemDefinition).InactiveActors.Add(EquipmentActor);
+	INC_DWORD_STAT(STAT_PooledEquipmentActors);
+}
+
+AActor* UInventoryComponent::SpawnEquipmentActor(TSubclassOf<AActor> ActorClass)
+{
+	check(ActorClass);
+
+	FActorSpawnParameters SpawnParams = FActorSpawnParameters();
+	SpawnParams.Owner = GetOwner();
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	const FTransform SpawnTransform = FTransform();
+
+	AActor* NewActor = GetWorld()->SpawnActor(ActorClass, &SpawnTransform, SpawnParams);
+	if (NewActor)
+	{
+		// Equipment actors are inactive until they are acquired.
+		SetEquipmentActorParked(NewActor, true);
+		INC_DWORD_STAT(STAT_EquipmentActorsSpawned);
+	}
 
-	// Add all slotted items first.
-	for (UInventoryItemInstance* Item : SlottedItems)
+	return NewActor;
+}
+
+void UInventoryComponent::SetEquipmentActorParked(AActor* EquipmentActor, bool bParked)
+{
+	ApplyEquipmentActorParked(EquipmentActor, bParked);
+
+	if (bParked)
+	{
+		ParkedEquipmentActors.AddUnique(EquipmentActor);
+	}
+	else
 	{
-		if (Item)
+		ParkedEquipmentActors.RemoveSingleSwap(EquipmentActor, false);
+	}
+}
+
+void UInventoryComponent::ApplyEquipmentActorParked(AActor* EquipmentActor, bool bParked)
+{
+	if (!IsValid(EquipmentActor))
+	{
+		return;
+	}
+
+	EquipmentActor->SetActorHiddenInGame(bParked);
+	EquipmentActor->SetActorEnableCollision(!bParked);
+	EquipmentActor->SetActorTickEnabled(!bParked);
+
+	/* Move parked actors out of the playable space. On clients, actors that are still attached are waiting for their
+	 * detachment to replicate; attachment is driven by the server, so they're left where they are. */
+	if (bParked)
+	{
+		if (EquipmentActor->HasAuthority())
 		{
-			OutItems.Add(Item);
+			EquipmentActor->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+		}
+
+		if (!EquipmentActor->GetAttachParentActor())
+		{
+			EquipmentActor->SetActorLocation(ParkedEquipmentActorLocation, false, nullptr, ETeleportType::ResetPhysics);
 		}
 	}
+}
 
-	// Add any non-slotted items in the order they were added to this array.
-	for (FInventoryListEntry& Entry : Inventory.Entries)
+void UInventoryComponent::OnRep_ParkedEquipmentActors()
+{
+	// Un-park actors that have been acquired since the last update.
+	for (const TWeakObjectPtr<AActor>& LocallyParkedActor : LocallyParkedEquipmentActors)
 	{
-		if (Entry.Item)
+		AActor* EquipmentActor = LocallyParkedActor.Get();
+		if (EquipmentActor && !ParkedEquipmentActors.Contains(EquipmentActor))
 		{
-			OutItems.AddUnique(Entry.Item);
+			ApplyEquipmentActorParked(EquipmentActor, false);
 		}
 	}
 
-	return OutItems;
+	// Park every actor that is parked on the server. Actors that haven't replicated yet are parked when they resolve.
+	LocallyParkedEquipmentActors.Reset();
+	for (AActor* EquipmentActor : ParkedEquipmentActors)
+	{
+		if (IsValid(EquipmentActor))
+		{
+			ApplyEquipmentActorParked(EquipmentActor, true);
+			LocallyParkedEquipmentActors.Add(EquipmentActor);
+		}
+	}
 }
 
-bool UInventoryComponent::IsItemInInventory(UInventoryItemInstance* ItemToCheck)
+TArray<UInventoryItemInstance*> UInventoryComponent::GetAllItems(TSubclassOf<UInventoryItemDefinition> FilterByClass)
 {
-	// Check the item of every entry in the inventory list for a matching item instance.
+	// Convert the inventory list entries into an array of pointers to each of their item instances.
+	TArray<UInventoryItemInstance*> OutItems;
 	for (FInventoryListEntry& Entry : Inventory.Entries)
 	{
-		if (Entry.Item && Entry.Item == ItemToCheck)
+		if (Entry.Item)
 		{
-			return true;
+			// If we aren't filtering by an item definition, return every item in the inventory.
+			if (FilterByClass == nullptr)
+			{
+				OutItems.Add(Entry.Item);
+			}
+			// If we are filtering by an item definition, only return items with the specified item definition class.
+			else if (Entry.Item->GetItemDefinition()->IsA(FilterByClass))
+			{
+				OutItems.Add(Entry.Item);
+			}
 		}
 	}
 
-	return false;
+	return OutItems;
+}
+
+TArray<UInventoryItemInstance*> UInventoryComponent::GetAllItemsOrdered()
+{
+	// The inventory list maintains its own sorted view of its items.
+	return TArray<UInventoryItemInstance*>(Inventory.GetOrderedItems());
+}
+
+bool UInventoryComponent::IsItemInInventory(UInventoryItemInstance* ItemToCheck)
+{
+	return Inventory.Contains(ItemToCheck);
 }
 
 void UInventoryComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
@@ -533,7 +835,7 @@ void UInventoryComponent::AddItemToSlot(UInventoryItemInstance* NewItem)
 		const uint8 SlotIndex = static_cast<uint8>(ItemSlot);
 
 		// Only place this item its corresponding slot if that slot is empty.
-		if (IsSlotOccupied(ItemSlot))
+		if (!IsSlotOccupied(ItemSlot))
 		{
 			SlottedItems[SlotIndex] = NewItem;
 		}
@@ -562,6 +864,8 @@ void UInventoryComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>&
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(UInventoryComponent, Inventory);
+	// Unequipped items are only replicated to the owner, so the rest of the inventory is too. Other clients only need the equipped item.
+	DOREPLIFETIME_CONDITION(UInventoryComponent, Inventory, COND_OwnerOnly);
 	DOREPLIFETIME(UInventoryComponent, CurrentlyEquippedItem);
+	DOREPLIFETIME(UInventoryComponent, ParkedEquipmentActors);
 }
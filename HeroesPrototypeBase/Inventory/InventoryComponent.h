@@ -12,6 +12,9 @@
 /** Native gameplay tags relevant to this class. */
 UE_DECLARE_GAMEPLAY_TAG_EXTERN(TAG_State_TemporarilyUnarmed);
 
+/** Stats used to profile the inventory system. */
+DECLARE_STATS_GROUP(TEXT("Heroes Inventory"), STATGROUP_HeroesInventory, STATCAT_Advanced);
+
 class UInventoryItemDefinition;
 
 /**
@@ -30,6 +33,19 @@ enum class EInventoryActionResult : uint8
 	Fail
 };
 
+/**
+ * A collection of inactive equipment actors for a single item definition. See UInventoryComponent::AcquireEquipmentActor.
+ */
+USTRUCT()
+struct FEquipmentActorPool
+{
+	GENERATED_BODY()
+
+	/** Equipment actors that are hidden and detached, waiting to be used by an equipped item. */
+	UPROPERTY()
+	TArray<TObjectPtr<AActor>> InactiveActors;
+};
+
 /**
  * Provides an actor with an "inventory," containing items that they can access through this component. This component
  * acts as an interface to the inventory system, providing various utility functions
@@ -55,14 +71,24 @@ public:
 	/** Initializes this component's properties. */
 	virtual void InitializeComponent() override;
 
+	/** Destroys this component's pooled equipment actors. */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 
 
 	// Networking.
 
 public:
 
-	/** Enables this component to replicate its inventory list as a sub-object. */
-	virtual bool ReplicateSubobjects(UActorChannel* Channel, FOutBunch* Bunch, FReplicationFlags* RepFlags) override;
+	/** Registers any items added before this component was ready to replicate as replicated sub-objects. */
+	virtual void ReadyForReplication() override;
+
+private:
+
+	/** Registers the given item as a replicated sub-object of this component, or updates its replication condition if
+	 * it's already registered. The equipped item is replicated to every connection, since everyone needs its
+	 * appearance; every other item is only replicated to the owning connection. */
+	void UpdateItemReplication(UInventoryItemInstance* Item);
 
 
 
@@ -107,6 +133,31 @@ public:
 	 * removed. */
 	void RemoveItem_Internal(UInventoryItemInstance* ItemToRemove);
 
+// Batching.
+public:
+
+	/** Begins a batch of inventory changes (e.g. granting a loadout). Until the batch is committed, added and removed
+	 * items are not marked for replication, and items are not automatically equipped, so the whole batch is replicated
+	 * and resolved at once. Batches can be nested; changes are committed when the outermost batch is committed. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Heroes|Inventory")
+	void BeginItemBatch();
+
+	/** Commits the current batch of inventory changes. Marks every added and removed item for replication, then
+	 * equips the highest-priority item if no item is equipped. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Heroes|Inventory")
+	void CommitItemBatch();
+
+	/** Returns whether a batch of inventory changes is in progress. */
+	bool IsBatchingItems() const { return ItemBatchDepth > 0; }
+
+private:
+
+	/** The number of batches that have begun but not been committed. */
+	int32 ItemBatchDepth = 0;
+
+	/** Whether an item should be equipped when the current batch is committed. */
+	bool bAutoEquipOnCommit = false;
+
 
 
 	// Equipment.
@@ -134,12 +185,75 @@ private:
 	UFUNCTION()
 	void OnTempUnarmedStateChanged(const FGameplayTag Callback, int32 NewCount);
 
+	/** Sets the currently equipped item, and updates the replication conditions of the old and new equipped items. */
+	void SetCurrentlyEquippedItem(UInventoryItemInstance* NewEquippedItem);
+
+	/** Reverts the owning hero to the "unarmed" character animation data when no item could be equipped. */
+	void ApplyUnarmedAnimationData();
+
 	/** Handle used to bind logic to when the TemporarilyUnarmed tag is added or removed from this component's owner's
 	 * ASC. */
 	FDelegateHandle TempUnarmedTagDelegate;
 
 
 
+	// Equipment actor pooling.
+
+public:
+
+	/** Spawns inactive equipment actors for the given item definition ahead of time, so equipping items of that
+	 * definition does not have to spawn them. Called when an equippable item enters this inventory.
+	 *
+	 * @param ItemDefinition	The item definition whose pool the actors are added to.
+	 * @param ActorClass		The class of the actors to spawn.
+	 * @param Count				The number of actors to spawn.
+	 */
+	void PrewarmEquipmentActors(TSubclassOf<UInventoryItemDefinition> ItemDefinition, TSubclassOf<AActor> ActorClass, int32 Count);
+
+	/** Destroys up to the given number of inactive equipment actors for the given item definition. Called when an
+	 * equippable item leaves this inventory, so pools don't outlive the items that use them. */
+	void TrimEquipmentActors(TSubclassOf<UInventoryItemDefinition> ItemDefinition, int32 Count);
+
+	/** Takes an inactive equipment actor from the given item definition's pool, or spawns a new one if the pool is
+	 * empty. The returned actor is visible, but is not attached to anything. */
+	AActor* AcquireEquipmentActor(TSubclassOf<UInventoryItemDefinition> ItemDefinition, TSubclassOf<AActor> ActorClass);
+
+	/** Hides and detaches the given equipment actor on every machine, moves it out of the playable space, and returns it
+	 * to the given item definition's pool so it can be re-used. */
+	void ReleaseEquipmentActor(TSubclassOf<UInventoryItemDefinition> ItemDefinition, AActor* EquipmentActor);
+
+private:
+
+	/** Spawns a new, inactive equipment actor of the given class. */
+	AActor* SpawnEquipmentActor(TSubclassOf<AActor> ActorClass);
+
+	/** Parks or un-parks the given equipment actor on the server, and replicates its new state to clients. See
+	 * @ParkedEquipmentActors. */
+	void SetEquipmentActorParked(AActor* EquipmentActor, bool bParked);
+
+	/** Applies the parked state to the given equipment actor on this machine. Parked actors are hidden, don't collide
+	 * or tick, and are moved out of the playable space. */
+	static void ApplyEquipmentActorParked(AActor* EquipmentActor, bool bParked);
+
+	/** Every pooled equipment actor that is currently parked. Only an actor's visibility and attachment replicate on
+	 * their own, so this is used to disable parked actors' collision and tick on clients too. */
+	UPROPERTY(ReplicatedUsing = OnRep_ParkedEquipmentActors)
+	TArray<TObjectPtr<AActor>> ParkedEquipmentActors;
+
+	/** The parked equipment actors that have been parked on this client, used to un-park the ones that are acquired. */
+	TArray<TWeakObjectPtr<AActor>> LocallyParkedEquipmentActors;
+
+	/** Parks newly parked equipment actors and un-parks acquired ones on clients. */
+	UFUNCTION()
+	void OnRep_ParkedEquipmentActors();
+
+	/** Inactive equipment actors owned by this inventory, pooled by the item definition that uses them. Equipment
+	 * actors are only spawned by the server. */
+	UPROPERTY()
+	TMap<TSubclassOf<UInventoryItemDefinition>, FEquipmentActorPool> EquipmentActorPools;
+
+
+
 	// Slotted items.
 
 // Utils.
@@ -203,17 +317,27 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Heroes|Inventory")
 	bool IsItemInInventory(UInventoryItemInstance* ItemToCheck);
 
+	/** Re-sorts this inventory's items the next time they're accessed. Called on clients when an item's definition is
+	 * replicated, since it can arrive after the item was added and sorted. */
+	void MarkItemOrderDirty() { Inventory.MarkOrderedItemsDirty(); }
+
 // Data.
 private:
 
-	/** A collection of item instance pointers that represent the contents of this inventory. */
+	/** A collection of item instance pointers that represent the contents of this inventory. Only replicated to the
+	 * owning client; other clients only receive CurrentlyEquippedItem. */
 	UPROPERTY(Replicated)
 	FInventoryList Inventory;
 
 	/** The item that is currently equipped, if there is one. */
-	UPROPERTY(Replicated)
+	UPROPERTY(ReplicatedUsing = OnRep_CurrentlyEquippedItem)
 	TObjectPtr<UInventoryItemInstance> CurrentlyEquippedItem = nullptr;
 
+	/** Prepares the newly equipped item on the owning client. Weapons' target actors are spawned and configured here,
+	 * since the owning client traces its own shots and the item is only equipped on the server. */
+	UFUNCTION()
+	void OnRep_CurrentlyEquippedItem();
+
 	/** The item that is currently equipped but is temporarily unequipped due to the TemporarilyUnequipped state. When
 	 * this component's owner loses that state, this item is automatically re-equipped. */
 	UPROPERTY(Replicated)
@@ -229,3 +353,31 @@ public:
 	 * contents for now. */
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 };
+
+/**
+ * Begins a batch of inventory changes on the given inventory component, and commits it when this scope ends. See
+ * UInventoryComponent::BeginItemBatch.
+ */
+struct FInventoryItemBatchScope
+{
+	FInventoryItemBatchScope(UInventoryComponent* InInventoryComponent)
+		: InventoryComponent(InInventoryComponent)
+	{
+		if (InventoryComponent)
+		{
+			InventoryComponent->BeginItemBatch();
+		}
+	}
+
+	~FInventoryItemBatchScope()
+	{
+		if (InventoryComponent)
+		{
+			InventoryComponent->CommitItemBatch();
+		}
+	}
+
+private:
+
+	UInventoryComponent* InventoryComponent;
+};
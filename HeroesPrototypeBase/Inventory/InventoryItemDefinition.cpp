@@ -3,26 +3,80 @@
 
 #include "Inventory/InventoryItemDefinition.h"
 
-TArray<UInventoryItemTraitBase*> UInventoryItemDefinition::GetTraits() const
+int32 FInventoryItemTraitTypeRegistry::GetTypeIndex(const UClass* TraitClass)
 {
-	TArray<UInventoryItemTraitBase*> OutTraits;
+	static FCriticalSection RegistryCritical;
+	static TMap<const UClass*, int32> TypeIndices;
 
-	for (UInventoryItemTraitBase* Trait : Traits)
+	if (!TraitClass)
 	{
-		if (Trait)
-		{
-			OutTraits.Add(Trait);
-		}
+		return INDEX_NONE;
+	}
+
+	FScopeLock RegistryLock(&RegistryCritical);
+
+	if (const int32* ExistingIndex = TypeIndices.Find(TraitClass))
+	{
+		return *ExistingIndex;
 	}
 
-	return OutTraits;
+	// Classes registered after the registry is full are never indexed.
+	const int32 NewIndex = TypeIndices.Num() < MaxTraitTypes ? TypeIndices.Num() : INDEX_NONE;
+	TypeIndices.Add(TraitClass, NewIndex);
+
+	return NewIndex;
+}
+
+void UInventoryItemDefinition::PostLoad()
+{
+	Super::PostLoad();
+
+	// Build the trait index ahead of time so it isn't built during gameplay.
+	BuildTraitIndex();
+}
+
+#if WITH_EDITOR
+void UInventoryItemDefinition::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	bTraitIndexBuilt = false;
+}
+#endif
+
+TConstArrayView<TObjectPtr<UInventoryItemTraitBase>> UInventoryItemDefinition::GetTraits() const
+{
+	ConditionalBuildTraitIndex();
+
+	return IndexedTraits;
 }
 
 UInventoryItemTraitBase* UInventoryItemDefinition::B_FindTraitByClass(TSubclassOf<UInventoryItemTraitBase> TraitToFind)
 {
-	for (UInventoryItemTraitBase* Trait : Traits)
+	return TraitToFind ? FindTraitByTypeIndex(FInventoryItemTraitTypeRegistry::GetTypeIndex(TraitToFind), TraitToFind) : nullptr;
+}
+
+int32 UInventoryItemDefinition::GetTraitIndex(const UInventoryItemTraitBase* Trait) const
+{
+	ConditionalBuildTraitIndex();
+
+	return Trait ? IndexedTraits.IndexOfByKey(Trait) : INDEX_NONE;
+}
+
+UInventoryItemTraitBase* UInventoryItemDefinition::FindTraitByTypeIndex(int32 TypeIndex, const UClass* TraitClass) const
+{
+	ConditionalBuildTraitIndex();
+
+	// Look up the trait directly if its class is indexed.
+	if (TypeIndex != INDEX_NONE)
 	{
-		if (Trait->IsA(TraitToFind))
+		return (TraitTypeMask & (1ull << TypeIndex)) ? IndexedTraits[TraitTypeSlots[TypeIndex]].Get() : nullptr;
+	}
+
+	// Search each trait if its class could not be indexed.
+	for (UInventoryItemTraitBase* Trait : IndexedTraits)
+	{
+		if (Trait->IsA(TraitClass))
 		{
 			return Trait;
 		}
@@ -30,3 +84,43 @@ UInventoryItemTraitBase* UInventoryItemDefinition::B_FindTraitByClass(TSubclassO
 
 	return nullptr;
 }
+
+void UInventoryItemDefinition::ConditionalBuildTraitIndex() const
+{
+	if (!bTraitIndexBuilt)
+	{
+		BuildTraitIndex();
+	}
+}
+
+void UInventoryItemDefinition::BuildTraitIndex() const
+{
+	IndexedTraits.Reset();
+	TraitTypeMask = 0;
+
+	for (UInventoryItemTraitBase* Trait : Traits)
+	{
+		if (!Trait)
+		{
+			continue;
+		}
+
+		// Trait indices are stored as bytes.
+		check(IndexedTraits.Num() < MAX_uint8);
+		const uint8 Slot = static_cast<uint8>(IndexedTraits.Add(Trait));
+
+		/* Index this trait under its class and each of its super-classes, so it can be found by any of them. If
+		 * multiple traits share a class, the first one is used. */
+		for (const UClass* TraitClass = Trait->GetClass(); TraitClass && TraitClass->IsChildOf(UInventoryItemTraitBase::StaticClass()); TraitClass = TraitClass->GetSuperClass())
+		{
+			const int32 TypeIndex = FInventoryItemTraitTypeRegistry::GetTypeIndex(TraitClass);
+			if (TypeIndex != INDEX_NONE && !(TraitTypeMask & (1ull << TypeIndex)))
+			{
+				TraitTypeMask |= (1ull << TypeIndex);
+				TraitTypeSlots[TypeIndex] = Slot;
+			}
+		}
+	}
+
+	bTraitIndexBuilt = true;
+}
@@ -21,10 +21,36 @@ enum class EItemDeathBehavior : uint8
 	Dropped
 };
 
+/**
+ * Assigns a small, stable index to each item trait class. Item definitions use these indices to look up their traits
+ * by class in constant time, instead of casting each of their traits.
+ */
+struct HEROESPROTOTYPEBASE_API FInventoryItemTraitTypeRegistry
+{
+	/** The maximum number of trait classes that can be indexed. Lookups for any classes beyond this fall back to
+	 * searching each trait. */
+	static constexpr int32 MaxTraitTypes = 64;
+
+	/** Returns the index of the given trait class, registering it if it hasn't been registered yet. Returns INDEX_NONE
+	 * if the registry is full. */
+	static int32 GetTypeIndex(const UClass* TraitClass);
+
+	/** Returns the index of the given trait class type. The index is cached after the first call. */
+	template <class T>
+	static int32 GetTypeIndex()
+	{
+		static const int32 TypeIndex = GetTypeIndex(T::StaticClass());
+		return TypeIndex;
+	}
+};
+
 /**
  * A collection of data that defines an inventory item. Items are defined by a set of universal data and a collection
- * of "traits." Each trait defines and holds runtime data for a specific property of the item; items only contain traits
- * that are relevant to them. For example, only items that can be equipped by the player have the "equippable" trait.
+ * of "traits." Each trait defines a specific property of the item; items only contain traits that are relevant to them.
+ * For example, only items that can be equipped by the player have the "equippable" trait.
+ *
+ * Item definitions are immutable at runtime. Every instance of an item shares its definition's class default object;
+ * data specific to each item instance is stored on the instance itself.
  */
 UCLASS(Abstract, Blueprintable)
 class HEROESPROTOTYPEBASE_API UInventoryItemDefinition : public UObject
@@ -38,6 +64,14 @@ public:
 	/** Default constructor. */
 	UInventoryItemDefinition() {};
 
+	/** Builds this definition's trait index once its traits have been loaded. */
+	virtual void PostLoad() override;
+
+#if WITH_EDITOR
+	/** Rebuilds this definition's trait index when its traits are edited. */
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
 
 
 	// Universal item data.
@@ -58,8 +92,8 @@ public:
 
 public:
 
-	/** Returns an array of this item's traits. */
-	TArray<UInventoryItemTraitBase*> GetTraits() const;
+	/** Returns a view of this item's traits. Empty trait entries are excluded. This does not allocate. */
+	TConstArrayView<TObjectPtr<UInventoryItemTraitBase>> GetTraits() const;
 
 	/** Returns this item definition's trait of the specified class. Returns nullptr if this item definition does not
 	 * have the specified trait. */
@@ -67,23 +101,48 @@ public:
 	T* FindTraitByClass() const
 	{
 		static_assert(TPointerIsConvertibleFromTo<T, UInventoryItemTraitBase>::Value, "'T' template parameter to FindTraitByClass must be derived from UInventoryItemTraitBase.");
-		for (UInventoryItemTraitBase* Trait : Traits)
-		{
-			if (Cast<T>(Trait))
-			{
-				return Cast<T>(Trait);
-			}
-		}
-
-		return nullptr;
+		return static_cast<T*>(FindTraitByTypeIndex(FInventoryItemTraitTypeRegistry::GetTypeIndex<T>(), T::StaticClass()));
 	}
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Heroes|Inventory", DisplayName = "Find Trait by Class")
 	UInventoryItemTraitBase* B_FindTraitByClass(TSubclassOf<UInventoryItemTraitBase> TraitToFind);
 
+	/** Returns the index of the given trait in this item definition's traits (see @GetTraits). Returns INDEX_NONE if
+	 * this item definition does not have the given trait. Trait indices are stable, since item definitions are
+	 * immutable at runtime. */
+	int32 GetTraitIndex(const UInventoryItemTraitBase* Trait) const;
+
+private:
+
+	/** Returns this definition's first trait of the given class, using the given class's trait type index. Falls back
+	 * to searching each trait if the class does not have a type index. */
+	UInventoryItemTraitBase* FindTraitByTypeIndex(int32 TypeIndex, const UClass* TraitClass) const;
+
+	/** Builds this definition's trait index if it hasn't been built yet. */
+	void ConditionalBuildTraitIndex() const;
+
+	/** Builds this definition's trait index: a list of its valid traits, a bitmask of the trait classes it has, and a
+	 * table mapping each of those classes to its trait. */
+	void BuildTraitIndex() const;
+
+	/** This definition's valid traits, in the order they were defined. */
+	UPROPERTY(Transient)
+	mutable TArray<TObjectPtr<UInventoryItemTraitBase>> IndexedTraits;
+
+	/** A bit for each trait type index, set if this definition has a trait of that class (or a subclass of it). */
+	mutable uint64 TraitTypeMask = 0;
+
+	/** The index in @IndexedTraits of this definition's first trait of each trait type. Only valid for types whose
+	 * bit is set in @TraitTypeMask. */
+	mutable uint8 TraitTypeSlots[FInventoryItemTraitTypeRegistry::MaxTraitTypes];
+
+	/** Whether this definition's trait index has been built. */
+	mutable bool bTraitIndexBuilt = false;
+
 protected:
 
-	/** This item definition's traits, which provide static data and hold relevant runtime data. */
+	/** This item definition's traits, which provide static data and logic. Traits are shared by every instance of
+	 * this item, so they cannot hold runtime data. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Display, Instanced)
 	TArray<TObjectPtr<UInventoryItemTraitBase>> Traits;
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 // Copyright Samuel Reitich 2024.
 
 #include "Inventory/InventoryItemInstance.h"
+#include "InventoryComponent.h"
 #include "InventoryItemDefinition.h"
 #include "Net/UnrealNetwork.h"
 #include "Player/PlayerStates/Game/HeroesGamePlayerStateBase.h"
@@ -16,8 +17,18 @@ void UInventoryItemInstance::Init(TSubclassOf<UInventoryItemDefinition> InItemDe
 	// Set this item's item definition to access static item data.
 	ItemDefinitionClass = InItemDefinition;
 
-	// Create a new instance of this item's definition object to hold runtime data for this item.
-	ItemDefinition = NewObject<UInventoryItemDefinition>(GetWorld(), InItemDefinition);
+	/* Use the definition's class default object instead of creating a new definition for each item. Definitions and
+	 * their traits are immutable at runtime; per-instance data is stored in this instance's trait states. */
+	ItemDefinition = GetDefault<UInventoryItemDefinition>(InItemDefinition);
+
+	// Create the runtime state for each of this item's traits before any trait logic runs.
+	InitializeTraitStates();
+
+	// Initialize this item's owner if it already has one, so traits can access it when entering its inventory.
+	if (IsValid(InCurrentOwner))
+	{
+		CurrentOwner = InCurrentOwner;
+	}
 
 	// Perform item initialization logic for each of this item's traits.
 	for (UInventoryItemTraitBase* Trait : ItemDefinition->GetTraits())
@@ -33,12 +44,6 @@ void UInventoryItemInstance::Init(TSubclassOf<UInventoryItemDefinition> InItemDe
 			}
 		}
 	}
-
-	// Initialize this item's owner if it already has one.
-	if (IsValid(InCurrentOwner))
-	{
-		CurrentOwner = InCurrentOwner;
-	}
 }
 
 void UInventoryItemInstance::BeginDestroy()
@@ -58,6 +63,97 @@ void UInventoryItemInstance::BeginDestroy()
 	UObject::BeginDestroy();
 }
 
+void UInventoryItemInstance::OnRep_ItemDefinitionClass()
+{
+	ItemDefinition = ItemDefinitionClass ? GetDefault<UInventoryItemDefinition>(ItemDefinitionClass) : nullptr;
+
+	// Replicated trait states are received from the server, but local trait states need to be created by clients.
+	InitializeTraitStates();
+
+	/* This item may have been added to its inventory before its definition arrived, in which case it was sorted as
+	 * un-slotted. Re-sort the inventory replicating this item, and the inventory of its owner in case it differs. */
+	if (const AHeroesGamePlayerStateBase* OuterPlayerState = GetTypedOuter<AHeroesGamePlayerStateBase>())
+	{
+		if (UInventoryComponent* InventoryComponent = OuterPlayerState->GetInventoryComponent())
+		{
+			InventoryComponent->MarkItemOrderDirty();
+		}
+	}
+
+	if (IsValid(CurrentOwner))
+	{
+		if (UInventoryComponent* InventoryComponent = CurrentOwner->GetInventoryComponent())
+		{
+			InventoryComponent->MarkItemOrderDirty();
+		}
+	}
+}
+
+void UInventoryItemInstance::InitializeTraitStates()
+{
+	if (!ItemDefinition)
+	{
+		return;
+	}
+
+	const AActor* OuterActor = GetTypedOuter<AActor>();
+	const bool bHasAuthority = !OuterActor || OuterActor->HasAuthority();
+
+	for (UInventoryItemTraitBase* Trait : ItemDefinition->GetTraits())
+	{
+		const UScriptStruct* StateType = Trait->GetRuntimeStateType();
+		if (!StateType)
+		{
+			continue;
+		}
+
+		const uint8 TraitIndex = static_cast<uint8>(ItemDefinition->GetTraitIndex(Trait));
+
+		// Replicated states are only created by the server.
+		if (Trait->ShouldReplicateRuntimeState())
+		{
+			if (bHasAuthority)
+			{
+				ReplicatedTraitStates.AddState(TraitIndex, StateType);
+			}
+		}
+		else
+		{
+			LocalTraitStates.AddState(TraitIndex, StateType);
+		}
+	}
+}
+
+const FInstancedStruct* UInventoryItemInstance::FindTraitState(const UInventoryItemTraitBase* Trait) const
+{
+	if (!Trait || !ItemDefinition)
+	{
+		return nullptr;
+	}
+
+	const int32 TraitIndex = ItemDefinition->GetTraitIndex(Trait);
+	if (TraitIndex == INDEX_NONE)
+	{
+		return nullptr;
+	}
+
+	return Trait->ShouldReplicateRuntimeState() ? ReplicatedTraitStates.FindState(TraitIndex) : LocalTraitStates.FindState(TraitIndex);
+}
+
+void UInventoryItemInstance::MarkTraitStateDirty(const UInventoryItemTraitBase* Trait)
+{
+	if (!Trait || !ItemDefinition || !Trait->ShouldReplicateRuntimeState())
+	{
+		return;
+	}
+
+	const int32 TraitIndex = ItemDefinition->GetTraitIndex(Trait);
+	if (TraitIndex != INDEX_NONE)
+	{
+		ReplicatedTraitStates.MarkStateDirty(TraitIndex);
+	}
+}
+
 const UInventoryItemDefinition* UInventoryItemInstance::GetItemDefinition() const
 {
 	return ItemDefinition;
@@ -93,7 +189,7 @@ void UInventoryItemInstance::GetLifetimeReplicatedProps(TArray<FLifetimeProperty
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
 	DOREPLIFETIME(ThisClass, ItemDefinitionClass);
-	DOREPLIFETIME(ThisClass, ItemDefinition);
+	DOREPLIFETIME(ThisClass, ReplicatedTraitStates);
 	DOREPLIFETIME(ThisClass, StatTags);
 	DOREPLIFETIME(ThisClass, CurrentOwner);
 }
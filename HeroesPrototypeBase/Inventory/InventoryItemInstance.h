@@ -4,10 +4,12 @@
 
 #include "CoreMinimal.h"
 #include "GameplayTagStack.h"
+#include "InventoryItemTraitState.h"
 #include "InventoryItemInstance.generated.h"
 
 class AHeroesGamePlayerStateBase;
 class UInventoryItemDefinition;
+class UInventoryItemTraitBase;
 
 /**
  * Represents a single instance of an item that exists in the game. Item instances should always either be in a
@@ -28,9 +30,9 @@ public:
 	/** Default constructor. */
 	UInventoryItemInstance();
 
-	/** Initializes this item instance with the specified item definition. Creates a new item definition object of the
-	 * specified class to hold runtime data for this item instance. Must be called when a new item instance is
-	 * created. */
+	/** Initializes this item instance with the specified item definition. Item instances share their definition's
+	 * class default object instead of creating their own definition; runtime data for each of the definition's traits is
+	 * stored on this instance. Must be called when a new item instance is created. */
 	virtual void Init(TSubclassOf<UInventoryItemDefinition> InItemDefinition, AHeroesGamePlayerStateBase* InCurrentOwner = nullptr);
 
 	/** Uninitializes all of this item instance's traits when the item is destroyed. */
@@ -45,6 +47,12 @@ public:
 	/** Allow this object to be referenced over the network. */
 	virtual bool IsSupportedForNetworking() const override { return true; }
 
+protected:
+
+	/** Resolves this item's shared definition object on clients when its definition class is replicated. */
+	UFUNCTION()
+	void OnRep_ItemDefinitionClass();
+
 
 
 	// Item data.
@@ -52,7 +60,8 @@ public:
 // Getters/setters.
 public:
 
-	/** Getter for this item's definition object. */
+	/** Getter for this item's definition object. This is the class default object of this item's definition class,
+	 * which is shared by every instance of this item. */
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Heroes|Inventory")
 	const UInventoryItemDefinition* GetItemDefinition() const;
 
@@ -82,17 +91,60 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Heroes|Inventory")
 	bool HasStatTag(FGameplayTag Tag) const;
 
+// Trait runtime state.
+public:
+
+	/** Returns this item's runtime state for the given trait. Returns nullptr if the trait is not one of this item's
+	 * traits or if its state is not of type T. */
+	template <typename T>
+	const T* GetTraitState(const UInventoryItemTraitBase* Trait) const
+	{
+		const FInstancedStruct* State = FindTraitState(Trait);
+		return State ? State->GetPtr<T>() : nullptr;
+	}
+
+	/** Returns this item's mutable runtime state for the given trait. Returns nullptr if the trait is not one of this
+	 * item's traits or if its state is not of type T. If the trait's state is replicated, MarkTraitStateDirty must be
+	 * called after modifying it. */
+	template <typename T>
+	T* GetMutableTraitState(const UInventoryItemTraitBase* Trait)
+	{
+		FInstancedStruct* State = const_cast<FInstancedStruct*>(FindTraitState(Trait));
+		return State ? State->GetMutablePtr<T>() : nullptr;
+	}
+
+	/** Marks the given trait's runtime state as dirty so that it will be replicated. Does nothing if the trait's state
+	 * is not replicated. */
+	void MarkTraitStateDirty(const UInventoryItemTraitBase* Trait);
+
+private:
+
+	/** Creates a runtime state for each of this item's traits that requires one. */
+	void InitializeTraitStates();
+
+	/** Returns this item's runtime state for the given trait, if it has one. */
+	const FInstancedStruct* FindTraitState(const UInventoryItemTraitBase* Trait) const;
+
 // Data.
 private:
 
-	/** The class of this inventory's item definition. This is used to access static data related to this item. */
-	UPROPERTY(Replicated)
+	/** The class of this inventory's item definition. This is used to access static data related to this item. This is
+	 * the only piece of the definition that is replicated; clients resolve the shared definition object from it. */
+	UPROPERTY(ReplicatedUsing = OnRep_ItemDefinitionClass)
 	TSubclassOf<UInventoryItemDefinition> ItemDefinitionClass;
 
-	/** The item definition object created by this item instance when initialized. This object holds item-specific
-	 * runtime data for this item instance. */
+	/** The shared definition object of this item: the class default object of @ItemDefinitionClass. This is cached
+	 * to avoid looking it up each time it's accessed. */
+	UPROPERTY(Transient)
+	TObjectPtr<const UInventoryItemDefinition> ItemDefinition;
+
+	/** Runtime states of this item's traits that are replicated. */
 	UPROPERTY(Replicated)
-	TObjectPtr<UInventoryItemDefinition> ItemDefinition;
+	FInventoryItemTraitStateContainer ReplicatedTraitStates;
+
+	/** Runtime states of this item's traits that are not replicated. */
+	UPROPERTY(Transient)
+	FInventoryItemTraitStateContainer LocalTraitStates;
 
 	/** A collection of gameplay tag stacks used to track runtime statistics for this item. E.g. a weapon's current
 	 * ammunition. */
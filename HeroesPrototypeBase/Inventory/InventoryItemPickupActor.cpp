@@ -3,11 +3,13 @@
 #include "Inventory/InventoryItemPickupActor.h"
 
 #include "Components/CapsuleComponent.h"
+#include "Components/StaticMeshComponent.h"
 #include "Engine/ActorChannel.h"
 #include "HeroesLogChannels.h"
 #include "InventoryComponent.h"
 #include "InventoryItemDefinition.h"
 #include "InventoryItemInstance.h"
+#include "InventoryItemPickupSubsystem.h"
 #include "Net/UnrealNetwork.h"
 #include "Player/PlayerStates/Game/HeroesGamePlayerStateBase.h"
 
@@ -30,6 +32,9 @@ AInventoryItemPickupActor::AInventoryItemPickupActor()
 	RootMesh->SetCollisionResponseToChannel(ECC_Visibility, ECR_Ignore);
 	RootMesh->SetCollisionResponseToChannel(ECC_Camera, ECR_Ignore);
 	RootMesh->SetCollisionResponseToChannel(ECC_Pawn, ECR_Ignore);
+	RootMesh->BodyInstance.bGenerateWakeEvents = true;
+	RootMesh->OnComponentSleep.AddDynamic(this, &AInventoryItemPickupActor::OnRootMeshSleep);
+	RootMesh->OnComponentHit.AddDynamic(this, &AInventoryItemPickupActor::OnRootMeshHit);
 
 	// Create the collision component for detecting overlaps.
 	OverlapCollision = CreateDefaultSubobject<UCapsuleComponent>(TEXT("Overlap Collision"));
@@ -43,6 +48,12 @@ AInventoryItemPickupActor::AInventoryItemPickupActor()
 	LookAtCollision->SetupAttachment(RootMesh);
 	LookAtCollision->ShapeColor = FColor(200, 100, 100);
 	LookAtCollision->InitCapsuleSize(50.0f, 50.0f);
+
+	// Create the proxy mesh, which is hidden until this actor stops simulating physics.
+	ProxyMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Proxy Mesh"));
+	ProxyMesh->SetupAttachment(RootMesh);
+	ProxyMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	ProxyMesh->SetVisibility(false);
 }
 
 void AInventoryItemPickupActor::Init(UInventoryItemInstance* InItemInstance)
@@ -69,35 +80,161 @@ void AInventoryItemPickupActor::BeginPlay()
 			RepresentedItemInstance->Init(RepresentedItemDefinitionClass);
 		}
 
-		// Do not utilize a pick-up cooldown if this item actor was not spawned with an instigator.
-		if (!GetInstigator())
-		{
-			bInstigatorCooldownExpired = true;
-		}
-		// Wait 0.25 seconds (arbitrary) before allowing the player who threw this item to pick it up again.
-		else
+		StartInstigatorCooldown();
+
+		// Let the pick-up subsystem limit this actor's physics simulation.
+		if (UInventoryItemPickupSubsystem* PickupSubsystem = GetWorld()->GetSubsystem<UInventoryItemPickupSubsystem>())
 		{
-			FTimerHandle MemberTimerHandle;
-			GetWorldTimerManager().SetTimer(MemberTimerHandle, FTimerDelegate::CreateLambda([&]
-			{
-				bInstigatorCooldownExpired = true;
-				GetWorldTimerManager().ClearTimer(MemberTimerHandle);
-			}), 0.25f, false);
+			PickupSubsystem->RegisterPickup(this);
 		}
 	}
 }
 
+void AInventoryItemPickupActor::StartInstigatorCooldown()
+{
+	// Do not utilize a pick-up cooldown if this item actor was not spawned with an instigator.
+	if (!GetInstigator())
+	{
+		bInstigatorCooldownExpired = true;
+	}
+	// Wait 0.25 seconds (arbitrary) before allowing the player who threw this item to pick it up again.
+	else if (UInventoryItemPickupSubsystem* PickupSubsystem = GetWorld()->GetSubsystem<UInventoryItemPickupSubsystem>())
+	{
+		PickupSubsystem->StartInstigatorCooldown(this, 0.25f);
+	}
+	// Cooldowns can't be tracked without the pick-up subsystem.
+	else
+	{
+		bInstigatorCooldownExpired = true;
+	}
+}
+
+void AInventoryItemPickupActor::ActivatePickup(UInventoryItemInstance* InItemInstance, const FTransform& InTransform, APawn* InInstigator)
+{
+	check(HasAuthority());
+
+	Init(InItemInstance);
+	SetInstigator(InInstigator);
+
+	// Wake this actor up so its new state is replicated.
+	SetNetDormancy(DORM_Awake);
+
+	bIsPickupActive = true;
+	bIsProxy = false;
+	bWasAtRestLastCheck = false;
+	SetActorTransform(InTransform, false, nullptr, ETeleportType::ResetPhysics);
+	ApplyPickupState();
+
+	StartInstigatorCooldown();
+	ForceNetUpdate();
+}
+
+void AInventoryItemPickupActor::DeactivatePickup()
+{
+	check(HasAuthority());
+
+	bIsPickupActive = false;
+	bIsProxy = false;
+	RepresentedItemInstance = nullptr;
+	ApplyPickupState();
+
+	// Replicate this actor's inactive state before it goes dormant.
+	ForceNetUpdate();
+	SetNetDormancy(DORM_DormantAll);
+}
+
+void AInventoryItemPickupActor::EnterProxyState()
+{
+	if (!HasAuthority() || bIsProxy || !bIsPickupActive)
+	{
+		return;
+	}
+
+	bIsProxy = true;
+	ApplyPickupState();
+}
+
+void AInventoryItemPickupActor::ExitProxyState()
+{
+	if (!HasAuthority() || !bIsProxy || !bIsPickupActive)
+	{
+		return;
+	}
+
+	bIsProxy = false;
+	bWasAtRestLastCheck = false;
+	ApplyPickupState();
+
+	// Let the pick-up subsystem limit this actor's physics simulation again.
+	if (UInventoryItemPickupSubsystem* PickupSubsystem = GetWorld()->GetSubsystem<UInventoryItemPickupSubsystem>())
+	{
+		PickupSubsystem->RegisterPickup(this);
+	}
+}
+
+bool AInventoryItemPickupActor::IsPickupAtRest() const
+{
+	// Pick-ups moving slower than this, in cm/s, are considered to be at rest.
+	static constexpr float RestingSpeed = 5.0f;
+
+	return !RootMesh->RigidBodyIsAwake() || RootMesh->GetPhysicsLinearVelocity().SizeSquared() <= FMath::Square(RestingSpeed);
+}
+
+void AInventoryItemPickupActor::OnRootMeshSleep(UPrimitiveComponent* SleepingComponent, FName BoneName)
+{
+	// A sleeping body doesn't need to simulate until something disturbs it, and pick-ups are rarely disturbed.
+	EnterProxyState();
+}
+
+void AInventoryItemPickupActor::OnRootMeshHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
+{
+	// Proxies don't react to physics, so resume simulating when something knocks into this pick-up.
+	ExitProxyState();
+}
+
+void AInventoryItemPickupActor::OnRep_PickupState()
+{
+	ApplyPickupState();
+}
+
+void AInventoryItemPickupActor::ApplyPickupState()
+{
+	const bool bSimulating = bIsPickupActive && !bIsProxy;
+	const bool bUseProxyMesh = bIsProxy && ProxyMesh->GetStaticMesh() != nullptr;
+
+	SetActorHiddenInGame(!bIsPickupActive);
+	SetActorEnableCollision(bIsPickupActive);
+
+	// Only simulating pick-ups need to move or animate their root mesh.
+	RootMesh->SetSimulatePhysics(bSimulating);
+	RootMesh->SetComponentTickEnabled(bSimulating);
+	RootMesh->SetVisibility(!bUseProxyMesh);
+	ProxyMesh->SetVisibility(bUseProxyMesh);
+
+	// Proxies listen for hits on the server, so they can resume simulating when they're disturbed.
+	RootMesh->SetNotifyRigidBodyCollision(HasAuthority() && bIsPickupActive && bIsProxy);
+}
+
 bool AInventoryItemPickupActor::ReplicateSubobjects(UActorChannel* Channel, FOutBunch* Bunch, FReplicationFlags* RepFlags)
 {
 	bool bWroteSomething = Super::ReplicateSubobjects(Channel, Bunch, RepFlags);
 
-	bWroteSomething |= Channel->ReplicateSubobject(RepresentedItemInstance, *Bunch, *RepFlags);
+	if (IsValid(RepresentedItemInstance))
+	{
+		bWroteSomething |= Channel->ReplicateSubobject(RepresentedItemInstance, *Bunch, *RepFlags);
+	}
 
 	return bWroteSomething;
 }
 
 void AInventoryItemPickupActor::OnPickUpOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
+	// Pooled pick-ups can't be picked up.
+	if (!bIsPickupActive || !IsValid(RepresentedItemInstance))
+	{
+		return;
+	}
+
 	// Do not let the player who dropped this item pick it up again until a short cooldown has expired.
 	if (OtherActor == GetInstigator() && !bInstigatorCooldownExpired)
 	{
@@ -111,10 +248,17 @@ void AInventoryItemPickupActor::OnPickUpOverlap(UPrimitiveComponent* OverlappedC
 			// Try to automatically pick up this item when a player overlaps it.
 			const EInventoryActionResult PickUpResult = HeroesPS->GetInventoryComponent()->AddItemSoft(RepresentedItemInstance);
 
-			// If the player successfully picked up this item, destroy the item actor.
+			// If the player successfully picked up this item, return the item actor to its pool.
 			if (PickUpResult == EInventoryActionResult::Success)
 			{
-				Destroy();
+				if (UInventoryItemPickupSubsystem* PickupSubsystem = GetWorld()->GetSubsystem<UInventoryItemPickupSubsystem>())
+				{
+					PickupSubsystem->ReleasePickup(this);
+				}
+				else
+				{
+					Destroy();
+				}
 			}
 		}
 	}
@@ -125,4 +269,6 @@ void AInventoryItemPickupActor::GetLifetimeReplicatedProps(TArray<FLifetimePrope
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
 	DOREPLIFETIME(AInventoryItemPickupActor, RepresentedItemInstance);
+	DOREPLIFETIME(AInventoryItemPickupActor, bIsPickupActive);
+	DOREPLIFETIME(AInventoryItemPickupActor, bIsProxy);
 }
\ No newline at end of file
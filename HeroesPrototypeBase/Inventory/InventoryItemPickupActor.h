@@ -12,6 +12,7 @@ class UInventoryItemInstance;
 class UBoxComponent;
 class UCapsuleComponent;
 class USkeletalMeshComponent;
+class UStaticMeshComponent;
 
 UCLASS()
 class HEROESPROTOTYPEBASE_API AInventoryItemPickupActor : public AActor
@@ -42,6 +43,76 @@ public:
 	 * who threw it. The player will be ignored until this cooldown expires. **/
 	bool bInstigatorCooldownExpired = false;
 
+	/** Identifies this pick-up's current instigator cooldown, so cooldowns started before this pick-up was re-used
+	 * are ignored. Managed by UInventoryItemPickupSubsystem. */
+	uint32 InstigatorCooldownId = 0;
+
+private:
+
+	/** Starts the cooldown before this item can be picked up by its instigator. */
+	void StartInstigatorCooldown();
+
+
+
+	// Pooling. Pick-up actors are recycled by UInventoryItemPickupSubsystem instead of being destroyed.
+
+public:
+
+	/** Re-initializes this pick-up after it's taken from its pool, placing it at the given transform and making it
+	 * represent the given item. */
+	void ActivatePickup(UInventoryItemInstance* InItemInstance, const FTransform& InTransform, APawn* InInstigator);
+
+	/** Hides this pick-up, disables its collision and physics, and makes it dormant so it can wait in its pool. */
+	void DeactivatePickup();
+
+	/** Stops this pick-up's physics simulation and switches it to its cheaper proxy mesh, if it has one. Pick-ups enter
+	 * this state when their physics bodies fall asleep, or when simulation limits are reached while they're at rest. */
+	void EnterProxyState();
+
+	/** Resumes this pick-up's physics simulation if it's in its proxy state. Pick-ups leave this state when something
+	 * hits them, or when simulation limits allow them to simulate again. Should also be called by anything else that
+	 * disturbs a pick-up (e.g. an explosion), since forces aren't applied to proxies. */
+	void ExitProxyState();
+
+	/** Returns whether this pick-up is active and simulating physics. */
+	bool IsSimulatingPickupPhysics() const { return bIsPickupActive && !bIsProxy; }
+
+	/** Returns whether this pick-up is active and in its proxy state. */
+	bool IsPickupProxy() const { return bIsPickupActive && bIsProxy; }
+
+	/** Returns whether this pick-up's physics body is asleep or barely moving. */
+	bool IsPickupAtRest() const;
+
+	/** Whether this pick-up was at rest the last time simulation limits were checked. Pick-ups are only limited once
+	 * they've been at rest for two checks in a row, so bodies that are briefly still (e.g. at the top of a throw) aren't
+	 * frozen in mid-air. Managed by UInventoryItemPickupSubsystem. */
+	bool bWasAtRestLastCheck = false;
+
+protected:
+
+	/** Enters the proxy state when this pick-up's physics body falls asleep. */
+	UFUNCTION()
+	void OnRootMeshSleep(UPrimitiveComponent* SleepingComponent, FName BoneName);
+
+	/** Exits the proxy state when a simulating body hits this pick-up. */
+	UFUNCTION()
+	void OnRootMeshHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
+
+	/** Applies this pick-up's active and proxy states to its components. */
+	UFUNCTION()
+	void OnRep_PickupState();
+
+	/** Applies this pick-up's active and proxy states to its components. */
+	void ApplyPickupState();
+
+	/** Whether this pick-up is currently placed in the world. Pick-ups are inactive while waiting in their pool. */
+	UPROPERTY(ReplicatedUsing = OnRep_PickupState)
+	bool bIsPickupActive = true;
+
+	/** Whether this pick-up has stopped simulating physics and is represented by its proxy mesh. */
+	UPROPERTY(ReplicatedUsing = OnRep_PickupState)
+	bool bIsProxy = false;
+
 
 
 	// Item data.
@@ -89,6 +160,9 @@ public:
 	/** Getter for the look-at-detection collision component. */
 	UCapsuleComponent* GetLookAtCollision() const { return LookAtCollision; }
 
+	/** Getter for the proxy mesh component. */
+	UStaticMeshComponent* GetProxyMesh() const { return ProxyMesh; }
+
 // Components.
 protected:
 
@@ -107,4 +181,9 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	TObjectPtr<UCapsuleComponent> LookAtCollision;
 
+	/** A cheap static mesh that replaces the root mesh once this item stops simulating physics. The root mesh is kept
+	 * visible if this component has no mesh. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TObjectPtr<UStaticMeshComponent> ProxyMesh;
+
 };
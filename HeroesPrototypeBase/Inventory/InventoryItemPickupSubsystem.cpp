@@ -0,0 +1,306 @@
+// Copyright Samuel Reitich 2024.
+
+
+#include "Inventory/InventoryItemPickupSubsystem.h"
+
+#include "InventoryComponent.h"
+#include "InventoryItemPickupActor.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Simulating Pick-Ups"), STAT_SimulatingPickups, STATGROUP_HeroesInventory);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pick-Ups Spawned"), STAT_PickupsSpawned, STATGROUP_HeroesInventory);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pick-Ups Reused"), STAT_PickupsReused, STATGROUP_HeroesInventory);
+
+static TAutoConsoleVariable<int32> CVarMaxSimulatingPickups
+(
+	TEXT("Heroes.Pickups.MaxSimulating"),
+	16,
+	TEXT("The maximum number of item pick-ups that can simulate physics at once. When exceeded, the oldest pick-ups")
+	TEXT(" are switched to their non-simulated proxy state."),
+	ECVF_Default
+);
+
+static TAutoConsoleVariable<float> CVarPickupSimulationDistance
+(
+	TEXT("Heroes.Pickups.SimulationDistance"),
+	5000.0f,
+	TEXT("Item pick-ups farther than this distance from every player stop simulating physics."),
+	ECVF_Default
+);
+
+static TAutoConsoleVariable<int32> CVarMaxPooledPickups
+(
+	TEXT("Heroes.Pickups.MaxPooled"),
+	32,
+	TEXT("The maximum number of inactive item pick-ups kept for re-use for each pick-up class."),
+	ECVF_Default
+);
+
+/** How often, in seconds, simulating pick-ups are checked against the simulation limits. */
+static constexpr float PickupSimulationCheckInterval = 0.25f;
+
+bool UInventoryItemPickupSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UInventoryItemPickupSubsystem::Deinitialize()
+{
+	for (TPair<TObjectPtr<UClass>, FInventoryItemPickupPool>& Pool : PickupPools)
+	{
+		for (AInventoryItemPickupActor* Pickup : Pool.Value.InactivePickups)
+		{
+			if (IsValid(Pickup))
+			{
+				Pickup->Destroy();
+			}
+		}
+	}
+
+	PickupPools.Empty();
+	SimulatingPickups.Empty();
+	OutOfRangePickups.Empty();
+	PendingCooldowns.Empty();
+
+	Super::Deinitialize();
+}
+
+AInventoryItemPickupActor* UInventoryItemPickupSubsystem::SpawnPickup(TSubclassOf<AInventoryItemPickupActor> PickupClass, const FTransform& Transform, UInventoryItemInstance* ItemInstance, APawn* PickupInstigator)
+{
+	UWorld* World = GetWorld();
+	if (!PickupClass || World->GetNetMode() == NM_Client)
+	{
+		return nullptr;
+	}
+
+	// Re-use an inactive pick-up of the same class if one is available.
+	if (FInventoryItemPickupPool* Pool = PickupPools.Find(PickupClass))
+	{
+		while (Pool->InactivePickups.Num() > 0)
+		{
+			AInventoryItemPickupActor* Pickup = Pool->InactivePickups.Pop(false);
+
+			// Pooled pick-ups can be destroyed externally (e.g. by a level transition).
+			if (IsValid(Pickup))
+			{
+				Pickup->ActivatePickup(ItemInstance, Transform, PickupInstigator);
+				RegisterPickup(Pickup);
+				INC_DWORD_STAT(STAT_PickupsReused);
+
+				return Pickup;
+			}
+		}
+	}
+
+	// Spawn and initialize a new pick-up if there aren't any to re-use. New pick-ups register themselves when spawned.
+	AInventoryItemPickupActor* Pickup = World->SpawnActorDeferred<AInventoryItemPickupActor>(PickupClass, Transform, nullptr, PickupInstigator, ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn);
+	if (!Pickup)
+	{
+		return nullptr;
+	}
+
+	Pickup->Init(ItemInstance);
+	Pickup->FinishSpawning(Transform);
+	INC_DWORD_STAT(STAT_PickupsSpawned);
+
+	return Pickup;
+}
+
+void UInventoryItemPickupSubsystem::ReleasePickup(AInventoryItemPickupActor* Pickup)
+{
+	if (!IsValid(Pickup))
+	{
+		return;
+	}
+
+	if (SimulatingPickups.Remove(Pickup) > 0)
+	{
+		DEC_DWORD_STAT(STAT_SimulatingPickups);
+	}
+
+	OutOfRangePickups.Remove(Pickup);
+
+	// Destroy the pick-up instead of pooling it if its pool is full.
+	FInventoryItemPickupPool& Pool = PickupPools.FindOrAdd(Pickup->GetClass());
+	if (Pool.InactivePickups.Num() >= CVarMaxPooledPickups.GetValueOnGameThread())
+	{
+		Pickup->Destroy();
+		return;
+	}
+
+	Pickup->DeactivatePickup();
+	Pool.InactivePickups.Add(Pickup);
+}
+
+void UInventoryItemPickupSubsystem::RegisterPickup(AInventoryItemPickupActor* Pickup)
+{
+	if (IsValid(Pickup) && Pickup->IsSimulatingPickupPhysics() && !SimulatingPickups.Contains(Pickup))
+	{
+		SimulatingPickups.Add(Pickup);
+		INC_DWORD_STAT(STAT_SimulatingPickups);
+	}
+}
+
+void UInventoryItemPickupSubsystem::StartInstigatorCooldown(AInventoryItemPickupActor* Pickup, float Duration)
+{
+	check(Pickup);
+
+	Pickup->bInstigatorCooldownExpired = false;
+
+	FInventoryItemPickupCooldown Cooldown;
+	Cooldown.Pickup = Pickup;
+	Cooldown.ExpirationTime = GetWorld()->GetTimeSeconds() + Duration;
+	Cooldown.CooldownId = ++Pickup->InstigatorCooldownId;
+
+	// Cooldowns almost always share a duration, so new cooldowns can usually be appended without breaking the order.
+	int32 InsertIndex = PendingCooldowns.Num();
+	while (InsertIndex > 0 && PendingCooldowns[InsertIndex - 1].ExpirationTime > Cooldown.ExpirationTime)
+	{
+		--InsertIndex;
+	}
+
+	PendingCooldowns.Insert(Cooldown, InsertIndex);
+}
+
+void UInventoryItemPickupSubsystem::ExpireInstigatorCooldowns()
+{
+	const double CurrentTime = GetWorld()->GetTimeSeconds();
+
+	// Cooldowns are sorted by expiration time, so stop at the first one that hasn't expired.
+	int32 NumExpired = 0;
+	for (; NumExpired < PendingCooldowns.Num(); ++NumExpired)
+	{
+		const FInventoryItemPickupCooldown& Cooldown = PendingCooldowns[NumExpired];
+		if (Cooldown.ExpirationTime > CurrentTime)
+		{
+			break;
+		}
+
+		AInventoryItemPickupActor* Pickup = Cooldown.Pickup.Get();
+		if (Pickup && Pickup->InstigatorCooldownId == Cooldown.CooldownId)
+		{
+			Pickup->bInstigatorCooldownExpired = true;
+		}
+	}
+
+	if (NumExpired > 0)
+	{
+		PendingCooldowns.RemoveAt(0, NumExpired, false);
+	}
+}
+
+void UInventoryItemPickupSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// Cooldowns are expired every frame, since they're short.
+	ExpireInstigatorCooldowns();
+
+	// These limits don't need to be enforced every frame.
+	TimeUntilSimulationCheck -= DeltaTime;
+	if (TimeUntilSimulationCheck > 0.0f)
+	{
+		return;
+	}
+
+	TimeUntilSimulationCheck = PickupSimulationCheckInterval;
+
+	// Stop tracking pick-ups that have stopped simulating on their own (e.g. their bodies fell asleep).
+	const int32 PreviousNum = SimulatingPickups.Num();
+	SimulatingPickups.RemoveAll([](const TWeakObjectPtr<AInventoryItemPickupActor>& Pickup)
+	{
+		return !Pickup.IsValid() || !Pickup->IsSimulatingPickupPhysics();
+	});
+	DEC_DWORD_STAT_BY(STAT_SimulatingPickups, PreviousNum - SimulatingPickups.Num());
+
+	// Stop tracking out-of-range pick-ups that have left their proxy state on their own (e.g. something hit them).
+	OutOfRangePickups.RemoveAll([](const TWeakObjectPtr<AInventoryItemPickupActor>& Pickup)
+	{
+		return !Pickup.IsValid() || !Pickup->IsPickupProxy();
+	});
+
+	if (SimulatingPickups.Num() == 0 && OutOfRangePickups.Num() == 0)
+	{
+		return;
+	}
+
+	// Gather the location of every player pawn to test the simulation distance.
+	TArray<FVector, TInlineAllocator<16>> PlayerLocations;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (const APawn* Pawn = It->IsValid() ? (*It)->GetPawn() : nullptr)
+		{
+			PlayerLocations.Add(Pawn->GetActorLocation());
+		}
+	}
+
+	const float SimulationDistance = CVarPickupSimulationDistance.GetValueOnGameThread();
+	const float SimulationDistanceSquared = SimulationDistance * SimulationDistance;
+	const int32 MaxSimulating = FMath::Max(0, CVarMaxSimulatingPickups.GetValueOnGameThread());
+
+	// Whether a pick-up is close enough to any player for its physics to be noticed.
+	auto IsInSimulationDistance = [&PlayerLocations, SimulationDistanceSquared](const AInventoryItemPickupActor* Pickup)
+	{
+		const FVector PickupLocation = Pickup->GetActorLocation();
+		for (const FVector& PlayerLocation : PlayerLocations)
+		{
+			if (FVector::DistSquared(PickupLocation, PlayerLocation) <= SimulationDistanceSquared)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	};
+
+	/* The oldest pick-ups over the cap stop simulating first. Only pick-ups that have come to rest are limited, since
+	 * stopping a moving body would freeze it in place; moving pick-ups are limited once they settle. */
+	int32 NumOverCap = SimulatingPickups.Num() - MaxSimulating;
+
+	for (int32 i = 0; i < SimulatingPickups.Num(); ++i)
+	{
+		AInventoryItemPickupActor* Pickup = SimulatingPickups[i].Get();
+
+		const bool bWasAtRest = Pickup->bWasAtRestLastCheck;
+		Pickup->bWasAtRestLastCheck = Pickup->IsPickupAtRest();
+		if (!bWasAtRest || !Pickup->bWasAtRestLastCheck)
+		{
+			continue;
+		}
+
+		const bool bOutOfRange = !IsInSimulationDistance(Pickup);
+		if (NumOverCap > 0 || bOutOfRange)
+		{
+			Pickup->EnterProxyState();
+			if (bOutOfRange)
+			{
+				OutOfRangePickups.Add(Pickup);
+			}
+
+			SimulatingPickups.RemoveAt(i--, 1, false);
+			DEC_DWORD_STAT(STAT_SimulatingPickups);
+			--NumOverCap;
+		}
+	}
+
+	// Resume simulating pick-ups that a player has come back into range of, oldest first, while there's room under the cap.
+	for (int32 i = 0; i < OutOfRangePickups.Num() && SimulatingPickups.Num() < MaxSimulating; ++i)
+	{
+		AInventoryItemPickupActor* Pickup = OutOfRangePickups[i].Get();
+		if (IsInSimulationDistance(Pickup))
+		{
+			OutOfRangePickups.RemoveAt(i--, 1, false);
+			Pickup->ExitProxyState();
+		}
+	}
+}
+
+bool UInventoryItemPickupSubsystem::IsTickable() const
+{
+	const UWorld* World = GetWorld();
+	return World && World->GetNetMode() != NM_Client && !IsTemplate();
+}
+
+TStatId UInventoryItemPickupSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UInventoryItemPickupSubsystem, STATGROUP_Tickables);
+}
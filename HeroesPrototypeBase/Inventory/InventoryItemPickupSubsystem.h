@@ -0,0 +1,143 @@
+// Copyright Samuel Reitich 2024.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "InventoryItemPickupSubsystem.generated.h"
+
+class AInventoryItemPickupActor;
+class UInventoryItemInstance;
+
+/**
+ * A collection of inactive pick-up actors of a single class.
+ */
+USTRUCT()
+struct FInventoryItemPickupPool
+{
+	GENERATED_BODY()
+
+	/** Pick-up actors that are hidden and dormant, waiting to represent a new item. */
+	UPROPERTY()
+	TArray<TObjectPtr<AInventoryItemPickupActor>> InactivePickups;
+};
+
+/**
+ * A pending instigator cooldown for a pick-up. See AInventoryItemPickupActor::bInstigatorCooldownExpired.
+ */
+struct FInventoryItemPickupCooldown
+{
+	/** The pick-up whose cooldown this is. */
+	TWeakObjectPtr<AInventoryItemPickupActor> Pickup;
+
+	/** The world time at which this cooldown expires. */
+	double ExpirationTime = 0.0;
+
+	/** The pick-up's cooldown ID when this cooldown started. Cooldowns are ignored if their pick-up has been re-used
+	 * since they started. */
+	uint32 CooldownId = 0;
+};
+
+/**
+ * Manages the item pick-up actors in a world on the server. Pick-up actors are recycled instead of being destroyed
+ * when they are picked up, and the number of pick-ups simulating physics at once is limited: once the cap is reached,
+ * or a pick-up is far from every player, the oldest pick-ups that are at rest are switched to their cheap,
+ * non-simulated proxy state. Pick-ups that are still moving keep simulating until they come to rest, even over the
+ * cap, so they're never frozen in mid-air. Pick-ups stopped for being out of range resume simulating when a player comes
+ * back into range and the cap allows it. Pick-ups also switch to their proxy state on their own when their physics bodies fall asleep, and
+ * leave it when something hits them.
+ *
+ * This subsystem also tracks every pick-up's instigator cooldown, expiring them together each tick.
+ */
+UCLASS()
+class HEROESPROTOTYPEBASE_API UInventoryItemPickupSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	// Subsystem.
+
+public:
+
+	/** Pick-ups only exist in game worlds. */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Destroys every pooled pick-up actor. */
+	virtual void Deinitialize() override;
+
+
+
+	// Pick-up management.
+
+public:
+
+	/**
+	 * Places a pick-up actor representing the given item into the world. Re-uses an inactive pick-up actor of the
+	 * given class if one is available; otherwise, spawns a new one. Only the server can spawn pick-ups.
+	 *
+	 * @param PickupClass		The class of pick-up actor to use.
+	 * @param Transform			Where to place the pick-up.
+	 * @param ItemInstance		The item that the pick-up will represent.
+	 * @param PickupInstigator	The pawn responsible for the pick-up (e.g. the pawn that dropped the item), if any.
+	 * @return					The placed pick-up actor.
+	 */
+	AInventoryItemPickupActor* SpawnPickup(TSubclassOf<AInventoryItemPickupActor> PickupClass, const FTransform& Transform, UInventoryItemInstance* ItemInstance, APawn* PickupInstigator);
+
+	/** Deactivates the given pick-up actor and returns it to its pool so it can be re-used. Called instead of destroying
+	 * pick-ups once they're picked up. */
+	void ReleasePickup(AInventoryItemPickupActor* Pickup);
+
+	/** Starts tracking the given pick-up actor's physics simulation, so it can be limited. Pick-ups register
+	 * themselves when they begin play. */
+	void RegisterPickup(AInventoryItemPickupActor* Pickup);
+
+private:
+
+	/** Active pick-ups that are simulating physics, ordered from oldest to newest. */
+	TArray<TWeakObjectPtr<AInventoryItemPickupActor>> SimulatingPickups;
+
+	/** Pick-ups that were switched to their proxy state for being too far from every player. These resume simulating
+	 * when a player comes back into range. */
+	TArray<TWeakObjectPtr<AInventoryItemPickupActor>> OutOfRangePickups;
+
+	/** Inactive pick-up actors, pooled by their class. */
+	UPROPERTY()
+	TMap<TObjectPtr<UClass>, FInventoryItemPickupPool> PickupPools;
+
+
+
+	// Instigator cooldowns.
+
+public:
+
+	/** Starts the given pick-up's instigator cooldown. The pick-up's bInstigatorCooldownExpired flag is set once the
+	 * cooldown expires. */
+	void StartInstigatorCooldown(AInventoryItemPickupActor* Pickup, float Duration);
+
+private:
+
+	/** Expires every pending cooldown whose expiration time has passed. */
+	void ExpireInstigatorCooldowns();
+
+	/** Pending instigator cooldowns, sorted by expiration time. */
+	TArray<FInventoryItemPickupCooldown> PendingCooldowns;
+
+
+
+	// Simulation limits.
+
+public:
+
+	/** Expires instigator cooldowns, enforces the simulating pick-up cap and simulation distance, and resumes simulating
+	 * pick-ups that players have come back into range of. */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Only the server ticks this subsystem, since only the server simulates pick-ups authoritatively. */
+	virtual bool IsTickable() const override;
+
+	virtual TStatId GetStatId() const override;
+
+private:
+
+	/** The time remaining until simulating pick-ups are checked against the simulation limits again. */
+	float TimeUntilSimulationCheck = 0.0f;
+};
@@ -0,0 +1,54 @@
+// Copyright Samuel Reitich 2024.
+
+
+#include "Inventory/InventoryItemTraitState.h"
+
+void FInventoryItemTraitStateContainer::AddState(uint8 TraitIndex, const UScriptStruct* StateType)
+{
+	check(StateType);
+
+	// Each trait can only have one state.
+	if (FindState(TraitIndex))
+	{
+		return;
+	}
+
+	FInventoryItemTraitStateEntry& NewEntry = Entries.Emplace_GetRef(TraitIndex, StateType);
+	MarkItemDirty(NewEntry);
+}
+
+FInstancedStruct* FInventoryItemTraitStateContainer::FindState(uint8 TraitIndex)
+{
+	for (FInventoryItemTraitStateEntry& Entry : Entries)
+	{
+		if (Entry.TraitIndex == TraitIndex)
+		{
+			return &Entry.State;
+		}
+	}
+
+	return nullptr;
+}
+
+const FInstancedStruct* FInventoryItemTraitStateContainer::FindState(uint8 TraitIndex) const
+{
+	return const_cast<FInventoryItemTraitStateContainer*>(this)->FindState(TraitIndex);
+}
+
+void FInventoryItemTraitStateContainer::MarkStateDirty(uint8 TraitIndex)
+{
+	for (FInventoryItemTraitStateEntry& Entry : Entries)
+	{
+		if (Entry.TraitIndex == TraitIndex)
+		{
+			MarkItemDirty(Entry);
+			return;
+		}
+	}
+}
+
+void FInventoryItemTraitStateContainer::Reset()
+{
+	Entries.Reset();
+	MarkArrayDirty();
+}
@@ -0,0 +1,114 @@
+// Copyright Samuel Reitich 2024.
+
+#pragma once
+
+#include "InstancedStruct.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "InventoryItemTraitState.generated.h"
+
+struct FInventoryItemTraitStateContainer;
+
+/**
+ * The runtime state of a single trait for a single item instance. Each entry holds a struct of the type requested by
+ * its trait (see UInventoryItemTraitBase::GetRuntimeStateType), keyed by the trait's index in its item definition.
+ */
+USTRUCT()
+struct FInventoryItemTraitStateEntry : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	/** Default constructor. */
+	FInventoryItemTraitStateEntry()
+	{}
+
+	/** Constructor initializing this entry's trait and the type of its state. */
+	FInventoryItemTraitStateEntry(uint8 InTraitIndex, const UScriptStruct* InStateType)
+		: TraitIndex(InTraitIndex)
+	{
+		State.InitializeAs(InStateType);
+	}
+
+private:
+
+	friend FInventoryItemTraitStateContainer;
+
+	/** The index of the trait that owns this state in its item definition's trait array. Trait indices are stable
+	 * because item definitions are immutable at runtime. */
+	UPROPERTY()
+	uint8 TraitIndex = 0;
+
+	/** The trait's state. */
+	UPROPERTY()
+	FInstancedStruct State;
+};
+
+/**
+ * A collection of trait runtime states owned by an item instance. Entries are stored contiguously and looked up by
+ * trait index; items only have a handful of stateful traits, so a linear search over this array is faster than a map.
+ *
+ * This container can be replicated with the fast array serializer. Item instances hold one replicated and one local
+ * container, so only traits that request replication pay for it.
+ */
+USTRUCT()
+struct FInventoryItemTraitStateContainer : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	// Construction.
+
+public:
+
+	/** Default constructor. */
+	FInventoryItemTraitStateContainer()
+	{}
+
+
+
+	// Fast array serializer implementation.
+
+public:
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParams)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FInventoryItemTraitStateEntry, FInventoryItemTraitStateContainer>(Entries, DeltaParams, *this);
+	}
+
+
+
+	// State management.
+
+public:
+
+	/** Adds a new state of the given type for the trait at the specified index. Does nothing if that trait already has
+	 * a state in this container. */
+	void AddState(uint8 TraitIndex, const UScriptStruct* StateType);
+
+	/** Returns the state of the trait at the specified index. Returns nullptr if this container does not have a state
+	 * for that trait. */
+	FInstancedStruct* FindState(uint8 TraitIndex);
+
+	/** Returns the state of the trait at the specified index. Returns nullptr if this container does not have a state
+	 * for that trait. */
+	const FInstancedStruct* FindState(uint8 TraitIndex) const;
+
+	/** Marks the state of the trait at the specified index as dirty so it will be replicated. */
+	void MarkStateDirty(uint8 TraitIndex);
+
+	/** Removes every state from this container. */
+	void Reset();
+
+private:
+
+	/** This container's trait states. */
+	UPROPERTY()
+	TArray<FInventoryItemTraitStateEntry> Entries;
+};
+
+/**
+ * Fast array serializer implementation.
+ */
+template<>
+struct TStructOpsTypeTraits<FInventoryItemTraitStateContainer> : public TStructOpsTypeTraitsBase2<FInventoryItemTraitStateContainer>
+{
+	enum { WithNetDeltaSerializer = true };
+};
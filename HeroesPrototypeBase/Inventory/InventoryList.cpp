@@ -2,7 +2,27 @@
 
 
 #include "Inventory/InventoryList.h"
+#include "InventoryItemDefinition.h"
 #include "InventoryItemInstance.h"
+#include "ItemTraits/SlottedItemTrait.h"
+
+void FInventoryList::PreReplicatedRemove(const TArrayView<int32>& RemovedIndices, int32 FinalSize)
+{
+	bItemIndicesDirty = true;
+	bOrderedItemsDirty = true;
+}
+
+void FInventoryList::PostReplicatedAdd(const TArrayView<int32>& AddedIndices, int32 FinalSize)
+{
+	bItemIndicesDirty = true;
+	bOrderedItemsDirty = true;
+}
+
+void FInventoryList::PostReplicatedChange(const TArrayView<int32>& ChangedIndices, int32 FinalSize)
+{
+	bItemIndicesDirty = true;
+	bOrderedItemsDirty = true;
+}
 
 TArray<const FInventoryListEntry*> FInventoryList::GetEntries() const
 {
@@ -25,28 +45,156 @@ void FInventoryList::AddEntry(UInventoryItemInstance* InItemInstance)
 	check(IsValid(InItemInstance));
 
 	// Construct a new entry in the inventory list and set its corresponding item instance.
-	FInventoryListEntry& NewEntry = Entries.AddDefaulted_GetRef();
+	ConditionalRebuildItemIndices();
+	const int32 NewIndex = Entries.AddDefaulted();
+	FInventoryListEntry& NewEntry = Entries[NewIndex];
 	NewEntry.Item = InItemInstance;
+	NewEntry.AddOrder = NextAddOrder++;
+
+	ItemIndices.Add(InItemInstance, NewIndex);
+	bOrderedItemsDirty = true;
 
-	MarkItemDirty(NewEntry);
+	if (bDeferDirty)
+	{
+		DeferredDirtyItems.Add(InItemInstance);
+	}
+	else
+	{
+		MarkItemDirty(NewEntry);
+	}
 }
 
 bool FInventoryList::RemoveEntry(UInventoryItemInstance* InItemInstance)
 {
-	// Search for an entry with the specified item instance.
-	for (auto It = Entries.CreateIterator(); It; ++It)
+	ConditionalRebuildItemIndices();
+
+	// Find the entry with the specified item instance.
+	int32 RemovedIndex;
+	if (!ItemIndices.RemoveAndCopyValue(InItemInstance, RemovedIndex))
+	{
+		// Return false if the specified item instance is not in this inventory.
+		return false;
+	}
+
+	/* Remove the entry by swapping the last entry into its place, so no other entries have to be moved. The order of
+	 * entries doesn't matter; items are ordered by their add order. */
+	Entries.RemoveAtSwap(RemovedIndex, 1, false);
+	if (Entries.IsValidIndex(RemovedIndex))
+	{
+		ItemIndices.Add(Entries[RemovedIndex].Item, RemovedIndex);
+	}
+
+	bOrderedItemsDirty = true;
+
+	if (bDeferDirty)
+	{
+		bDeferredArrayDirty = true;
+	}
+	else
+	{
+		MarkArrayDirty();
+	}
+
+	return true;
+}
+
+void FInventoryList::BeginDeferredDirty()
+{
+	bDeferDirty = true;
+}
+
+void FInventoryList::EndDeferredDirty()
+{
+	if (!bDeferDirty)
+	{
+		return;
+	}
+
+	bDeferDirty = false;
+
+	// Mark each new entry dirty. Entries that were added and removed in the same batch are skipped.
+	for (const UInventoryItemInstance* Item : DeferredDirtyItems)
 	{
-		FInventoryListEntry& Entry = *It;
-		if (Entry.Item == InItemInstance)
+		if (const int32* EntryIndex = ItemIndices.Find(Item))
 		{
-			// Remove the entry with the specified item instance if one was found.
-			It.RemoveCurrent();
-			MarkArrayDirty();
+			MarkItemDirty(Entries[*EntryIndex]);
+		}
+	}
+
+	if (bDeferredArrayDirty)
+	{
+		MarkArrayDirty();
+	}
+
+	DeferredDirtyItems.Reset();
+	bDeferredArrayDirty = false;
+}
+
+bool FInventoryList::Contains(const UInventoryItemInstance* InItemInstance) const
+{
+	ConditionalRebuildItemIndices();
+
+	return InItemInstance && ItemIndices.Contains(InItemInstance);
+}
+
+TConstArrayView<UInventoryItemInstance*> FInventoryList::GetOrderedItems() const
+{
+	ConditionalRebuildOrderedItems();
+
+	return OrderedItems;
+}
+
+void FInventoryList::ConditionalRebuildItemIndices() const
+{
+	if (!bItemIndicesDirty)
+	{
+		return;
+	}
 
-			return true;
+	ItemIndices.Reset();
+	for (int32 EntryIndex = 0; EntryIndex < Entries.Num(); ++EntryIndex)
+	{
+		// Entries' items may not be resolved yet on clients.
+		if (const UInventoryItemInstance* Item = Entries[EntryIndex].Item)
+		{
+			ItemIndices.Add(Item, EntryIndex);
 		}
 	}
 
-	// Return false if the specified item instance is not in this inventory.
-	return false;
+	bItemIndicesDirty = false;
 }
+
+void FInventoryList::ConditionalRebuildOrderedItems() const
+{
+	if (!bOrderedItemsDirty)
+	{
+		return;
+	}
+
+	/* Gather each valid item with its sort key: slotted items are sorted by their slot, followed by un-slotted items.
+	 * Ties are broken by the order in which items were added. */
+	TArray<TPair<uint64, UInventoryItemInstance*>, TInlineAllocator<16>> SortedItems;
+	for (const FInventoryListEntry& Entry : Entries)
+	{
+		if (UInventoryItemInstance* Item = Entry.Item)
+		{
+			const USlottedItemTrait* SlotTrait = Item->GetItemDefinition() ? Item->GetItemDefinition()->FindTraitByClass<USlottedItemTrait>() : nullptr;
+			const uint64 SlotKey = SlotTrait ? static_cast<uint64>(SlotTrait->Slot) : static_cast<uint64>(MAX_uint8) + 1;
+			const uint64 SortKey = (SlotKey << 32) | Entry.AddOrder;
+			SortedItems.Emplace(SortKey, Item);
+		}
+	}
+
+	SortedItems.Sort([](const TPair<uint64, UInventoryItemInstance*>& A, const TPair<uint64, UInventoryItemInstance*>& B)
+	{
+		return A.Key < B.Key;
+	});
+
+	OrderedItems.Reset();
+	for (const TPair<uint64, UInventoryItemInstance*>& SortedItem : SortedItems)
+	{
+		OrderedItems.Add(SortedItem.Value);
+	}
+
+	bOrderedItemsDirty = false;
+}
\ No newline at end of file
@@ -31,6 +31,12 @@ private:
 	/** The item instance represented by this entry. */
 	UPROPERTY()
 	TObjectPtr<UInventoryItemInstance> Item = nullptr;
+
+	/** The order in which this entry was added to its list, relative to the list's other entries. Used to order
+	 * un-slotted items identically on servers and clients, since the fast array serializer does not preserve the order
+	 * of its entries. */
+	UPROPERTY()
+	uint32 AddOrder = 0;
 };
 
 /**
@@ -61,6 +67,16 @@ public:
 		return FFastArraySerializer::FastArrayDeltaSerialize<FInventoryListEntry, FInventoryList>(Entries, DeltaParams, *this);
 	}
 
+	/** Invalidates this list's item indices before entries are removed on clients. */
+	void PreReplicatedRemove(const TArrayView<int32>& RemovedIndices, int32 FinalSize);
+
+	/** Invalidates this list's item indices after entries are added on clients. */
+	void PostReplicatedAdd(const TArrayView<int32>& AddedIndices, int32 FinalSize);
+
+	/** Invalidates this list's item indices after entries are changed on clients (e.g. when an entry's item is
+	 * resolved). */
+	void PostReplicatedChange(const TArrayView<int32>& ChangedIndices, int32 FinalSize);
+
 
 
 	// Inventory management.
@@ -80,6 +96,33 @@ public:
 	 */
 	bool RemoveEntry(UInventoryItemInstance* InItemInstance);
 
+	/** Defers marking added and removed entries dirty until @EndDeferredDirty is called, so a batch of changes is
+	 * replicated together. */
+	void BeginDeferredDirty();
+
+	/** Marks every entry added or removed since @BeginDeferredDirty dirty, and stops deferring. */
+	void EndDeferredDirty();
+
+	/** Returns whether this inventory list has an entry for the given item instance. */
+	bool Contains(const UInventoryItemInstance* InItemInstance) const;
+
+	/** Returns every item instance in this inventory list, sorted by priority. Slotted items are always prioritized
+	 * first, by their slot. Un-slotted items are prioritized by the order in which they were added. The returned view
+	 * is invalidated when this list changes. */
+	TConstArrayView<UInventoryItemInstance*> GetOrderedItems() const;
+
+	/** Re-sorts this list's items the next time they're accessed. Used on clients when an item's definition is
+	 * replicated after its entry, since items without a definition are sorted as un-slotted. */
+	void MarkOrderedItemsDirty() { bOrderedItemsDirty = true; }
+
+private:
+
+	/** Rebuilds this list's item indices if any entries have changed since they were last built. */
+	void ConditionalRebuildItemIndices() const;
+
+	/** Rebuilds this list's ordered items if any entries have changed since they were last sorted. */
+	void ConditionalRebuildOrderedItems() const;
+
 
 
 	// Inventory data.
@@ -92,6 +135,30 @@ private:
 	 * replicated by the fast array serializer. */
 	UPROPERTY()
 	TArray<FInventoryListEntry> Entries;
+
+	/** Maps each item instance in this list to the index of its entry in @Entries. */
+	mutable TMap<const UInventoryItemInstance*, int32> ItemIndices;
+
+	/** Every item instance in this list, sorted by priority. See @GetOrderedItems. */
+	mutable TArray<UInventoryItemInstance*> OrderedItems;
+
+	/** Whether @ItemIndices needs to be rebuilt. Only set on clients, whose entries are changed by replication. */
+	mutable bool bItemIndicesDirty = false;
+
+	/** Whether @OrderedItems needs to be re-sorted. */
+	mutable bool bOrderedItemsDirty = false;
+
+	/** The add order to assign to the next entry added to this list. */
+	uint32 NextAddOrder = 0;
+
+	/** Whether added and removed entries are currently being marked dirty later. See @BeginDeferredDirty. */
+	bool bDeferDirty = false;
+
+	/** Items whose entries were added while dirtying was deferred. */
+	TArray<const UInventoryItemInstance*> DeferredDirtyItems;
+
+	/** Whether any entries were removed while dirtying was deferred. */
+	bool bDeferredArrayDirty = false;
 };
 
 /**
@@ -17,14 +17,15 @@ void UAbilitySystemItemTrait::OnItemEnteredInventory(UInventoryItemInstance* Ite
 	Super::OnItemEnteredInventory(ItemInstance);
 
 	UHeroesAbilitySystemComponent* HeroesASC = UHeroesAbilitySystemGlobals::GetHeroesAbilitySystemComponentFromActor(ItemInstance->GetCurrentOwner());
-	if (HeroesASC)
+	FAbilitySystemItemTraitState* State = ItemInstance->GetMutableTraitState<FAbilitySystemItemTraitState>(this);
+	if (HeroesASC && State)
 	{
 		// Grant each ability set specified by this trait and save a handle to it to remove it later.
 		for (const UHeroesAbilitySet* Set : AbilitySetsToGrant)
 		{
 			if (Set)
 			{
-				Set->GiveToAbilitySystem(HeroesASC, &GrantedAbilitySetHandles.AddDefaulted_GetRef(), ItemInstance);
+				Set->GiveToAbilitySystem(HeroesASC, &State->GrantedAbilitySetHandles.AddDefaulted_GetRef(), ItemInstance);
 			}
 		}
 	}
@@ -35,15 +36,16 @@ void UAbilitySystemItemTrait::OnItemLeftInventory(UInventoryItemInstance* ItemIn
 	Super::OnItemLeftInventory(ItemInstance);
 
 	UHeroesAbilitySystemComponent* HeroesASC = UHeroesAbilitySystemGlobals::GetHeroesAbilitySystemComponentFromActor(ItemInstance->GetCurrentOwner());
-	if (HeroesASC)
+	FAbilitySystemItemTraitState* State = ItemInstance->GetMutableTraitState<FAbilitySystemItemTraitState>(this);
+	if (HeroesASC && State)
 	{
 		// Remove every granted ability set from this actor's owner.
-		for (FHeroesAbilitySet_GrantedHandles& Handle : GrantedAbilitySetHandles)
+		for (FHeroesAbilitySet_GrantedHandles& Handle : State->GrantedAbilitySetHandles)
 		{
 			Handle.RemoveFromAbilitySystem(HeroesASC);
 		}
 
 		// Empty the array of handles for granted ability sets.
-		GrantedAbilitySetHandles.Empty();
+		State->GrantedAbilitySetHandles.Empty();
 	}
 }
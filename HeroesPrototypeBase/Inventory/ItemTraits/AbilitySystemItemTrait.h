@@ -9,6 +9,21 @@
 
 class UInventoryItemInstance;
 
+/**
+ * Runtime data used by the "Grants Ability Sets" trait. This is stored on each item instance, since the trait is
+ * shared between every instance of its item.
+ */
+USTRUCT(BlueprintType)
+struct FAbilitySystemItemTraitState
+{
+	GENERATED_BODY()
+
+	/** The handles for the ability sets currently applied by this item. Used to remove the ability sets when this item
+	 * is remove from its current inventory. */
+	UPROPERTY()
+	TArray<FHeroesAbilitySet_GrantedHandles> GrantedAbilitySetHandles;
+};
+
 /**
  * Provides this item's owner with a collection of ability sets while the item is in their inventory. These ability
  * sets are removed when this item is removed from the inventory.
@@ -26,6 +41,9 @@ public:
 	/** Removes this item's ability sets from the owner of the specified item instance. */
 	virtual void OnItemLeftInventory(UInventoryItemInstance* ItemInstance) override;
 
+	/** Granted ability set handles are stored in a FAbilitySystemItemTraitState. */
+	virtual const UScriptStruct* GetRuntimeStateType() const override { return FAbilitySystemItemTraitState::StaticStruct(); }
+
 
 
 	// Static data.
@@ -35,14 +53,4 @@ protected:
 	/** The ability sets to grant this item's owner while it is in their inventory. */
 	UPROPERTY(EditDefaultsOnly)
 	TArray<TObjectPtr<UHeroesAbilitySet>> AbilitySetsToGrant;
-
-
-
-	// Runtime data.
-
-protected:
-
-	/** The handles for the ability sets currently applied by this item. Used to remove the ability sets when this item
-	 * is remove from its current inventory. */
-	TArray<FHeroesAbilitySet_GrantedHandles> GrantedAbilitySetHandles;
 };
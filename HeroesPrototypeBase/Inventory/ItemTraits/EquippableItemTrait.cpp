@@ -9,31 +9,74 @@
 #include "Animation/CharacterAnimationData/ItemCharacterAnimationData.h"
 #include "Characters/Components/FirstPersonSkeletalMeshComponent.h"
 #include "Characters/Heroes/HeroBase.h"
+#include "Inventory/InventoryComponent.h"
+#include "Inventory/InventoryItemDefinition.h"
 #include "Inventory/InventoryItemInstance.h"
+#include "Inventory/ItemTraits/WeaponItemTrait.h"
 #include "Player/PlayerStates/Game/HeroesGamePlayerStateBase.h"
 
+DECLARE_CYCLE_STAT(TEXT("Equip Item"), STAT_EquipItem, STATGROUP_HeroesInventory);
+DECLARE_CYCLE_STAT(TEXT("Unequip Item"), STAT_UnequipItem, STATGROUP_HeroesInventory);
+
+/** The number of equipment actors used by each equipped item: one for each perspective. */
+static constexpr int32 EquipmentActorsPerItem = 2;
+
+/** Returns the inventory of the given item's current owner, which owns the item's pooled equipment actors. */
+static UInventoryComponent* GetOwningInventory(const UInventoryItemInstance* ItemInstance)
+{
+	const AHeroesGamePlayerStateBase* OwningPlayerState = ItemInstance->GetCurrentOwner();
+	return OwningPlayerState ? OwningPlayerState->GetInventoryComponent() : nullptr;
+}
+
+void UEquippableItemTrait::OnItemEnteredInventory(UInventoryItemInstance* ItemInstance)
+{
+	Super::OnItemEnteredInventory(ItemInstance);
+
+	// Spawn this item's equipment actors ahead of time so they don't have to be spawned when this item is equipped.
+	if (UInventoryComponent* Inventory = GetOwningInventory(ItemInstance))
+	{
+		Inventory->PrewarmEquipmentActors(ItemInstance->GetItemDefinition()->GetClass(), ActorToSpawnOnEquip, EquipmentActorsPerItem);
+	}
+}
+
+void UEquippableItemTrait::OnItemLeftInventory(UInventoryItemInstance* ItemInstance)
+{
+	Super::OnItemLeftInventory(ItemInstance);
+
+	// Destroy the equipment actors that were pooled for this item.
+	if (UInventoryComponent* Inventory = GetOwningInventory(ItemInstance))
+	{
+		Inventory->TrimEquipmentActors(ItemInstance->GetItemDefinition()->GetClass(), EquipmentActorsPerItem);
+	}
+}
+
 void UEquippableItemTrait::OnEquipped(UInventoryItemInstance* ItemToEquip)
 {
-	AHeroBase* EquippingHero = Cast<AHeroBase>(ItemToEquip->GetCurrentOwner()->GetPawn());
+	SCOPE_CYCLE_COUNTER(STAT_EquipItem);
 
-	FActorSpawnParameters SpawnParams = FActorSpawnParameters();
-	SpawnParams.Owner = const_cast<AHeroesGamePlayerStateBase*>(ItemToEquip->GetCurrentOwner());
-	SpawnParams.Instigator = EquippingHero;
-	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-	const FTransform SpawnTransform = FTransform();
+	AHeroBase* EquippingHero = Cast<AHeroBase>(ItemToEquip->GetCurrentOwner()->GetPawn());
+	UInventoryComponent* Inventory = GetOwningInventory(ItemToEquip);
+	const TSubclassOf<UInventoryItemDefinition> ItemDefinitionClass = ItemToEquip->GetItemDefinition()->GetClass();
 	const FAttachmentTransformRules AttachRules = FAttachmentTransformRules(EAttachmentRule::SnapToTarget, false);
 
 	check(ActorToSpawnOnEquip);
+	check(Inventory);
+
+	// This trait is shared between item instances, so its state is stored on the item being equipped.
+	FEquippableItemTraitState* State = ItemToEquip->GetMutableTraitState<FEquippableItemTraitState>(this);
+	check(State);
 
-	// Spawn the item's first-person actor.
-	FirstPersonEquippedActor = GetWorld()->SpawnActor(ActorToSpawnOnEquip, &SpawnTransform, SpawnParams);
-	FirstPersonEquippedActor->AttachToComponent(EquippingHero->GetFirstPersonMesh(), AttachRules, EquipmentAttachSocketNames[AttachmentSocket]);
-	FirstPersonEquippedActor->SetActorRelativeTransform(AttachmentOffset);
+	// Take the item's first-person actor from its owner's equipment pool.
+	State->FirstPersonEquippedActor = Inventory->AcquireEquipmentActor(ItemDefinitionClass, ActorToSpawnOnEquip);
+	State->FirstPersonEquippedActor->SetInstigator(EquippingHero);
+	State->FirstPersonEquippedActor->AttachToComponent(EquippingHero->GetFirstPersonMesh(), AttachRules, EquipmentAttachSocketNames[AttachmentSocket]);
+	State->FirstPersonEquippedActor->SetActorRelativeTransform(AttachmentOffset);
 
-	// Spawn the item's third-person actor.
-	ThirdPersonEquippedActor = GetWorld()->SpawnActor(ActorToSpawnOnEquip, &SpawnTransform, SpawnParams);
-	ThirdPersonEquippedActor->AttachToComponent(EquippingHero->GetThirdPersonMesh(), AttachRules, EquipmentAttachSocketNames[AttachmentSocket]);
-	ThirdPersonEquippedActor->SetActorRelativeTransform(AttachmentOffset);
+	// Take the item's third-person actor from its owner's equipment pool.
+	State->ThirdPersonEquippedActor = Inventory->AcquireEquipmentActor(ItemDefinitionClass, ActorToSpawnOnEquip);
+	State->ThirdPersonEquippedActor->SetInstigator(EquippingHero);
+	State->ThirdPersonEquippedActor->AttachToComponent(EquippingHero->GetThirdPersonMesh(), AttachRules, EquipmentAttachSocketNames[AttachmentSocket]);
+	State->ThirdPersonEquippedActor->SetActorRelativeTransform(AttachmentOffset);
 
 
 	// Grant each of this item's on-equipped ability sets.
@@ -41,7 +84,13 @@ void UEquippableItemTrait::OnEquipped(UInventoryItemInstance* ItemToEquip)
 	{
 		for (const UHeroesAbilitySet* Set : GrantedAbilitySetsOnEquip)
 		{
-			Set->GiveToAbilitySystem(HeroesASC, &GrantedAbilitySetHandles.Add_GetRef(FHeroesAbilitySet_GrantedHandles()), ItemToEquip);
+			Set->GiveToAbilitySystem(HeroesASC, &State->GrantedAbilitySetHandles.Add_GetRef(FHeroesAbilitySet_GrantedHandles()), ItemToEquip);
+		}
+
+		// Spawn and configure weapons' target actors now, so they don't have to be when the weapon is first fired.
+		if (ItemToEquip->GetItemDefinition()->FindTraitByClass<UWeaponItemTrait>())
+		{
+			HeroesASC->GetWeaponTargetActor(ItemToEquip);
 		}
 	}
 
@@ -62,20 +111,60 @@ void UEquippableItemTrait::OnEquipped(UInventoryItemInstance* ItemToEquip)
 
 void UEquippableItemTrait::OnUnequipped(UInventoryItemInstance* ItemToUnequip)
 {
-	// Destroy both item actors.
-	FirstPersonEquippedActor->Destroy();
-	ThirdPersonEquippedActor->Destroy();
+	SCOPE_CYCLE_COUNTER(STAT_UnequipItem);
+
+	FEquippableItemTraitState* State = ItemToUnequip->GetMutableTraitState<FEquippableItemTraitState>(this);
+	check(State);
+
+	// Return both item actors to their owner's equipment pool instead of destroying them.
+	const TSubclassOf<UInventoryItemDefinition> ItemDefinitionClass = ItemToUnequip->GetItemDefinition()->GetClass();
+	if (UInventoryComponent* Inventory = GetOwningInventory(ItemToUnequip))
+	{
+		Inventory->ReleaseEquipmentActor(ItemDefinitionClass, State->FirstPersonEquippedActor);
+		Inventory->ReleaseEquipmentActor(ItemDefinitionClass, State->ThirdPersonEquippedActor);
+	}
+	else
+	{
+		State->FirstPersonEquippedActor->Destroy();
+		State->ThirdPersonEquippedActor->Destroy();
+	}
+
+	State->FirstPersonEquippedActor = nullptr;
+	State->ThirdPersonEquippedActor = nullptr;
 
 	// Remove each of this item's on-equipped ability sets.
 	const AHeroBase* UnequippingHero = ItemToUnequip->GetCurrentOwner()->GetPawn<AHeroBase>();
 	if (UHeroesAbilitySystemComponent* HeroesASC = UHeroesAbilitySystemGlobals::GetHeroesAbilitySystemComponentFromActor(UnequippingHero))
 	{
-		for (FHeroesAbilitySet_GrantedHandles Set : GrantedAbilitySetHandles)
+		for (FHeroesAbilitySet_GrantedHandles& Set : State->GrantedAbilitySetHandles)
 		{
 			Set.RemoveFromAbilitySystem(HeroesASC);
 		}
 	}
 
+	// Clear the handles so they aren't removed again the next time this item is unequipped.
+	State->GrantedAbilitySetHandles.Empty();
+
 	// Call any item-specific equipment logic.
 	B_OnUnequipped(ItemToUnequip);
 }
+
+/** Returns the given item's equippable trait state, if it has one. */
+static const FEquippableItemTraitState* FindEquippableState(const UInventoryItemInstance* ItemInstance)
+{
+	const UInventoryItemDefinition* ItemDefinition = IsValid(ItemInstance) ? ItemInstance->GetItemDefinition() : nullptr;
+	const UEquippableItemTrait* EquippableTrait = ItemDefinition ? ItemDefinition->FindTraitByClass<UEquippableItemTrait>() : nullptr;
+	return EquippableTrait ? ItemInstance->GetTraitState<FEquippableItemTraitState>(EquippableTrait) : nullptr;
+}
+
+AActor* UEquippableItemTrait::GetFirstPersonEquippedActor(const UInventoryItemInstance* ItemInstance)
+{
+	const FEquippableItemTraitState* State = FindEquippableState(ItemInstance);
+	return State ? State->FirstPersonEquippedActor.Get() : nullptr;
+}
+
+AActor* UEquippableItemTrait::GetThirdPersonEquippedActor(const UInventoryItemInstance* ItemInstance)
+{
+	const FEquippableItemTraitState* State = FindEquippableState(ItemInstance);
+	return State ? State->ThirdPersonEquippedActor.Get() : nullptr;
+}
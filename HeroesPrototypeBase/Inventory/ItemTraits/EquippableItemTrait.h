@@ -8,6 +8,7 @@
 #include "EquippableItemTrait.generated.h"
 
 class UHeroesAbilitySet;
+class UInventoryItemInstance;
 class UItemCharacterAnimationData;
 
 /**
@@ -29,6 +30,28 @@ static TMap<EEquipmentAttachSocket, FName> EquipmentAttachSocketNames
 	{ EEquipmentAttachSocket::Hand, FName("EquipSocket_Hand") }
 };
 
+/**
+ * Runtime data used by the "Equippable" trait. This is stored on each item instance, since equippable traits are
+ * shared between every instance of their item. See UInventoryItemTraitBase::GetRuntimeStateType.
+ */
+USTRUCT(BlueprintType)
+struct FEquippableItemTraitState
+{
+	GENERATED_BODY()
+
+	/** The actor that represents this item in first-person when equipped. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+	TObjectPtr<AActor> FirstPersonEquippedActor = nullptr;
+
+	/** The actor that represents this item in third-person when equipped. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+	TObjectPtr<AActor> ThirdPersonEquippedActor = nullptr;
+
+	/** A collection of handles for ability sets granted to the player while this item is equipped. */
+	UPROPERTY()
+	TArray<FHeroesAbilitySet_GrantedHandles> GrantedAbilitySetHandles;
+};
+
 /**
  * Allows this item to be equipped by players. Defines data and logic used to equip this item.
  */
@@ -37,17 +60,29 @@ class HEROESPROTOTYPEBASE_API UEquippableItemTrait : public UInventoryItemTraitB
 {
 	GENERATED_BODY()
 
+	// Inventory logic.
+
+public:
+
+	/** Pre-warms the owning inventory's equipment actor pool with this item's equipment actors. */
+	virtual void OnItemEnteredInventory(UInventoryItemInstance* ItemInstance) override;
+
+	/** Trims the owning inventory's equipment actor pool of this item's equipment actors. */
+	virtual void OnItemLeftInventory(UInventoryItemInstance* ItemInstance) override;
+
+
+
 	// Equipment logic.
 
 public:
 
-	/** Called when the player equips this item. Default implementation spawns and attaches this item's actor, grants
-	 * this item's equipped ability sets, updates the character's animation data, and plays this item's "equip"
-	 * animation. */
+	/** Called when the player equips this item. Default implementation takes this item's actors from the owner's
+	 * equipment pool and attaches them, grants this item's equipped ability sets, updates the character's animation
+	 * data, and plays this item's "equip" animation. */
 	virtual void OnEquipped(UInventoryItemInstance* ItemToEquip);
 
-	/** Called when the player unequips this item. Default implementation destroys this item's actor and removes this
-	 * item's equipped ability sets. */
+	/** Called when the player unequips this item. Default implementation returns this item's actors to the owner's
+	 * equipment pool and removes this item's equipped ability sets. */
 	virtual void OnUnequipped(UInventoryItemInstance* ItemToUnequip);
 
 	/** Blueprint-implemented event called when the player equips this item. Called after @OnEquipped. */
@@ -65,7 +100,8 @@ public:
 // Actor spawned when this item is equipped.
 public:
 
-	/** The actor that will be spawned when this item is equipped and destroyed when unequipped. */
+	/** The actor that represents this item while it's equipped. These actors are pooled by the owning inventory, so
+	 * they are hidden and detached when this item is unequipped, rather than destroyed. */
 	UPROPERTY(EditDefaultsOnly, Category = "Equipped Actor", DisplayName = "Actor to Spawn When This Item is Equipped")
 	TSubclassOf<AActor> ActorToSpawnOnEquip;
 
@@ -104,14 +140,14 @@ public:
 
 public:
 
-	/** The actor that represents this item in first-person when equipped. */
-	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
-	TObjectPtr<AActor> FirstPersonEquippedActor = nullptr;
+	/** Equippable items store their equipped actors and granted ability sets in a FEquippableItemTraitState. */
+	virtual const UScriptStruct* GetRuntimeStateType() const override { return FEquippableItemTraitState::StaticStruct(); }
 
-	/** The actor that represents this item in third-person when equipped. */
-	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
-	TObjectPtr<AActor> ThirdPersonEquippedActor = nullptr;
+	/** Returns the actor that represents the given item in first-person while it's equipped. */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Heroes|Inventory")
+	static AActor* GetFirstPersonEquippedActor(const UInventoryItemInstance* ItemInstance);
 
-	/** A collection of handles for ability sets granted to the player while this item is equipped. */
-	TArray<FHeroesAbilitySet_GrantedHandles> GrantedAbilitySetHandles;
+	/** Returns the actor that represents the given item in third-person while it's equipped. */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Heroes|Inventory")
+	static AActor* GetThirdPersonEquippedActor(const UInventoryItemInstance* ItemInstance);
 };
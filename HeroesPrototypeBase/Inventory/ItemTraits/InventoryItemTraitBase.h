@@ -9,8 +9,11 @@ class UInventoryItemInstance;
 
 /**
  * The base class for all item traits. Item traits are used by inventory item definitions to define the properties of
- * an item and hold runtime data specific to that item. Each item trait defines and holds data for a unique property,
- * such as whether or not an item can be equipped.
+ * an item. Each item trait defines data for a unique property, such as whether or not an item can be equipped.
+ *
+ * Traits are shared by every instance of their item, so they must not store runtime data themselves. Traits that need
+ * runtime data declare a state struct with GetRuntimeStateType, and each item instance stores one of those structs
+ * for the trait.
  */
 UCLASS(Abstract, DefaultToInstanced, EditInlineNew)
 class HEROESPROTOTYPEBASE_API UInventoryItemTraitBase : public UObject
@@ -32,4 +35,17 @@ public:
 	 * directly removed by the system or when it is dropped by the owning actor. */
 	virtual void OnItemLeftInventory(UInventoryItemInstance* ItemInstance) {};
 
+
+
+	// Runtime state.
+
+public:
+
+	/** Returns the struct type that item instances use to store this trait's runtime data. Returns nullptr if this
+	 * trait does not have any runtime data. */
+	virtual const UScriptStruct* GetRuntimeStateType() const { return nullptr; }
+
+	/** Whether this trait's runtime state should be replicated to clients. Most trait state is only used by the server,
+	 * so it is not replicated by default. */
+	virtual bool ShouldReplicateRuntimeState() const { return false; }
 };
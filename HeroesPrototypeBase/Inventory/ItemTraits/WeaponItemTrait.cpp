@@ -3,3 +3,143 @@
 
 #include "Inventory/ItemTraits/WeaponItemTrait.h"
 
+#include "GameFramework/GameStateBase.h"
+#include "Inventory/InventoryItemDefinition.h"
+#include "Inventory/InventoryItemInstance.h"
+#include "Inventory/ItemTraits/WeaponStaticDataAsset.h"
+#include "Player/PlayerStates/Game/HeroesGamePlayerStateBase.h"
+
+/** Weapon heat cools down in fixed steps of this many per second, so every machine derives the same heat from the same
+ * shot timestamps, regardless of its frame rate. */
+static constexpr double WeaponHeatStepsPerSecond = 60.0;
+
+/** Returns the given item's weapon trait, if it has one. */
+static const UWeaponItemTrait* FindWeaponTrait(const UInventoryItemInstance* WeaponItem)
+{
+	const UInventoryItemDefinition* ItemDefinition = IsValid(WeaponItem) ? WeaponItem->GetItemDefinition() : nullptr;
+	return ItemDefinition ? ItemDefinition->FindTraitByClass<UWeaponItemTrait>() : nullptr;
+}
+
+/** Returns the current server world time of the given item's owner's world. */
+static double GetServerTime(const UInventoryItemInstance* WeaponItem)
+{
+	const AHeroesGamePlayerStateBase* OwningPlayerState = WeaponItem->GetCurrentOwner();
+	const UWorld* World = OwningPlayerState ? OwningPlayerState->GetWorld() : nullptr;
+	if (!World)
+	{
+		return 0.0;
+	}
+
+	const AGameStateBase* GameState = World->GetGameState();
+	return GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+}
+
+/** Derives a weapon's heat at the given time from the heat and timestamp of its last shot. */
+static float ComputeWeaponHeat(const FWeaponItemTraitState& State, const UWeaponStaticDataAsset* WeaponData, double Time)
+{
+	if (!WeaponData || State.CurrentWeaponHeat <= 0.0f)
+	{
+		return FMath::Max(State.CurrentWeaponHeat, 0.0f);
+	}
+
+	// The weapon doesn't start cooling down until its cooldown delay has passed.
+	const int64 ElapsedSteps = FMath::FloorToInt64((Time - State.LastShotTime) * WeaponHeatStepsPerSecond);
+	const int64 DelaySteps = FMath::CeilToInt64(WeaponData->TimeBeforeHeatCooldown * WeaponHeatStepsPerSecond);
+	const int64 CooldownSteps = ElapsedSteps - DelaySteps;
+
+	if (CooldownSteps <= 0)
+	{
+		return State.CurrentWeaponHeat;
+	}
+
+	if (WeaponData->HeatCooldownRate <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	// HeatCooldownRate is the time it takes to cool down from full heat.
+	const double CooledHeat = CooldownSteps / (WeaponData->HeatCooldownRate * WeaponHeatStepsPerSecond);
+	return (float)FMath::Max(State.CurrentWeaponHeat - CooledHeat, 0.0);
+}
+
+const FWeaponItemTraitState* UWeaponItemTrait::GetWeaponState(const UInventoryItemInstance* WeaponItem)
+{
+	const UWeaponItemTrait* WeaponTrait = FindWeaponTrait(WeaponItem);
+	return WeaponTrait ? WeaponItem->GetTraitState<FWeaponItemTraitState>(WeaponTrait) : nullptr;
+}
+
+FWeaponItemTraitState* UWeaponItemTrait::GetMutableWeaponState(UInventoryItemInstance* WeaponItem)
+{
+	const UWeaponItemTrait* WeaponTrait = FindWeaponTrait(WeaponItem);
+	return WeaponTrait ? WeaponItem->GetMutableTraitState<FWeaponItemTraitState>(WeaponTrait) : nullptr;
+}
+
+float UWeaponItemTrait::GetCurrentWeaponHeat(const UInventoryItemInstance* WeaponItem)
+{
+	return IsValid(WeaponItem) ? GetWeaponHeatAtTime(WeaponItem, GetServerTime(WeaponItem)) : 0.0f;
+}
+
+float UWeaponItemTrait::GetWeaponHeatAtTime(const UInventoryItemInstance* WeaponItem, double Time)
+{
+	const UWeaponItemTrait* WeaponTrait = FindWeaponTrait(WeaponItem);
+	const FWeaponItemTraitState* State = WeaponTrait ? WeaponItem->GetTraitState<FWeaponItemTraitState>(WeaponTrait) : nullptr;
+	return State ? ComputeWeaponHeat(*State, WeaponTrait->StaticData, Time) : 0.0f;
+}
+
+float UWeaponItemTrait::GetWeaponHeatStep(const UInventoryItemInstance* WeaponItem)
+{
+	const UWeaponItemTrait* WeaponTrait = FindWeaponTrait(WeaponItem);
+	const UWeaponStaticDataAsset* WeaponData = WeaponTrait ? WeaponTrait->StaticData.Get() : nullptr;
+	if (!WeaponData)
+	{
+		return 0.0f;
+	}
+
+	// Weapons without a cooldown time lose all of their heat in a single step.
+	return WeaponData->HeatCooldownRate > 0.0f ? (float)(1.0 / (WeaponData->HeatCooldownRate * WeaponHeatStepsPerSecond)) : 1.0f;
+}
+
+float UWeaponItemTrait::FireWeapon(UInventoryItemInstance* WeaponItem, double ShotTime)
+{
+	const UWeaponItemTrait* WeaponTrait = FindWeaponTrait(WeaponItem);
+	FWeaponItemTraitState* State = WeaponTrait ? WeaponItem->GetMutableTraitState<FWeaponItemTraitState>(WeaponTrait) : nullptr;
+	if (!State)
+	{
+		return 0.0f;
+	}
+
+	// Heat can only be advanced forward in time.
+	ShotTime = FMath::Max(ShotTime, State->LastShotTime);
+
+	const UWeaponStaticDataAsset* WeaponData = WeaponTrait->StaticData;
+	const float HeatAtShot = ComputeWeaponHeat(*State, WeaponData, ShotTime);
+
+	State->PreviousWeaponHeat = HeatAtShot;
+	State->CurrentWeaponHeat = FMath::Min(HeatAtShot + (WeaponData ? WeaponData->HeatRate : 0.0f), 1.0f);
+	State->LastShotTime = ShotTime;
+
+	return HeatAtShot;
+}
+
+void UWeaponItemTrait::SetCurrentWeaponHeat(UInventoryItemInstance* WeaponItem, float NewHeat)
+{
+	if (FWeaponItemTraitState* State = GetMutableWeaponState(WeaponItem))
+	{
+		State->CurrentWeaponHeat = NewHeat;
+		State->LastShotTime = GetServerTime(WeaponItem);
+	}
+}
+
+float UWeaponItemTrait::GetPreviousWeaponHeat(const UInventoryItemInstance* WeaponItem)
+{
+	const FWeaponItemTraitState* State = GetWeaponState(WeaponItem);
+	return State ? State->PreviousWeaponHeat : 0.0f;
+}
+
+void UWeaponItemTrait::SetPreviousWeaponHeat(UInventoryItemInstance* WeaponItem, float NewHeat)
+{
+	if (FWeaponItemTraitState* State = GetMutableWeaponState(WeaponItem))
+	{
+		State->PreviousWeaponHeat = NewHeat;
+	}
+}
@@ -3,68 +3,115 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Components/TimelineComponent.h"
 #include "Inventory/ItemTraits/InventoryItemTraitBase.h"
 #include "WeaponItemTrait.generated.h"
 
 class UCurveVector;
+class UInventoryItemInstance;
 class UWeaponStaticDataAsset;
 
 /**
- * Designates this item as a weapon. Defines static weapon-related data and stores runtime data specific to each
- * weapon. We could alternatively put all of the static data into a "weapon data" data asset and have an object pointer
- * to that asset here.
+ * Runtime data used by the "Weapon" trait. This is stored on each item instance, since weapon traits are shared
+ * between every instance of their item.
  */
-UCLASS(DisplayName = "Weapon", BlueprintType)
-class HEROESPROTOTYPEBASE_API UWeaponItemTrait : public UInventoryItemTraitBase
+USTRUCT(BlueprintType)
+struct FWeaponItemTraitState
 {
 	GENERATED_BODY()
 
-	// Static data.
-
-public:
-
-	/** Static data for this weapon stored as a data asset. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
-	TObjectPtr<UWeaponStaticDataAsset> StaticData;
-
-
-
-	// Runtime data.
-
-public:
-
 	/** Determines recoil curve position and accuracy over time. Increases with each shot, decreases over time when
-	 * not firing. */
+	 * not firing. This is the heat immediately after the last shot (or the last time the heat was set); the weapon's
+	 * heat at any later time is derived from it (see UWeaponItemTrait::GetWeaponHeatAtTime). */
 	UPROPERTY(BlueprintReadWrite)
 	float CurrentWeaponHeat = 0.0;
 
 	/** The weapon heat at the time of the last shot. */
 	UPROPERTY(BlueprintReadWrite)
-	float PreviousWeaponHeat;
+	float PreviousWeaponHeat = 0.0;
 
-
-	
-
-	/** The time that has passed since the last shot was fired. Updates when another shot is fired. */
-	float TimeSinceLastShot;
+	/** The server world time at which CurrentWeaponHeat was last changed, by a shot or otherwise. The weapon starts
+	 * cooling down from this time. */
+	double LastShotTime = 0.0;
 
 	/** Timer used to control a weapon's rate of fire. Weapons with a maximum fire-rate must wait a certain amount of
 	 * time between shots. */
 	FTimerHandle TimeBetweenShots;
 
-	/** The timeline handling the weapon's current recoil. Uses the recoil curve from this weapon's static data. */
-	FTimeline RecoilTimeline;
-
-	/** The timeline handling the weapon's recoil recovery when it stops firing. */
-	FTimeline RecoilRecoveryTimeline;
-
 	/** The rotation to return to if recoil recovery is enabled. If the player's rotation after they stop firing is
 	 * drastically different from this, their rotation will not be reset. */
-	FRotator ControlRotationBeforeFiring;
+	FRotator ControlRotationBeforeFiring = FRotator::ZeroRotator;
 
 	/** Whether recoil will recover after this shot(s). This is set to false if the player attempts to control their
 	 * recoil. */
 	bool bShouldRecoverRecoil = true;
+};
+
+/**
+ * Designates this item as a weapon. Defines static weapon-related data. Runtime data specific to each weapon is stored
+ * on its item instance (see FWeaponItemTraitState). We could alternatively put all of the static data into a "weapon
+ * data" data asset and have an object pointer to that asset here.
+ */
+UCLASS(DisplayName = "Weapon", BlueprintType)
+class HEROESPROTOTYPEBASE_API UWeaponItemTrait : public UInventoryItemTraitBase
+{
+	GENERATED_BODY()
+
+	// Static data.
+
+public:
+
+	/** Static data for this weapon stored as a data asset. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	TObjectPtr<UWeaponStaticDataAsset> StaticData;
+
+
+
+	// Runtime data.
+
+public:
 
+	/** Weapons store their heat and recoil state in a FWeaponItemTraitState. */
+	virtual const UScriptStruct* GetRuntimeStateType() const override { return FWeaponItemTraitState::StaticStruct(); }
+
+	/** Returns the weapon state of the given item. Returns nullptr if the item is not a weapon. */
+	static const FWeaponItemTraitState* GetWeaponState(const UInventoryItemInstance* WeaponItem);
+
+	/** Returns the mutable weapon state of the given item. Returns nullptr if the item is not a weapon. */
+	static FWeaponItemTraitState* GetMutableWeaponState(UInventoryItemInstance* WeaponItem);
+
+	/** Returns the given weapon's current heat. */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Heroes|Inventory|Weapons")
+	static float GetCurrentWeaponHeat(const UInventoryItemInstance* WeaponItem);
+
+	/**
+	 * Returns the given weapon's heat at the given server world time. Heat is derived from the heat and timestamp of the
+	 * weapon's last shot, with its cooldown advanced in fixed steps, so it doesn't need to be ticked and is identical
+	 * on every machine that knows when the last shot was fired.
+	 */
+	static float GetWeaponHeatAtTime(const UInventoryItemInstance* WeaponItem, double Time);
+
+	/** Returns how much heat the given weapon loses in each of its fixed cooldown steps. */
+	static float GetWeaponHeatStep(const UInventoryItemInstance* WeaponItem);
+
+	/**
+	 * Fires a shot with the given weapon at the given server world time, heating it up by its heat rate. Shots fired
+	 * before the weapon's last shot are treated as being fired at the same time as it.
+	 *
+	 * @return					The weapon's heat when the shot was fired, before it was heated up by the shot.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Heroes|Inventory|Weapons")
+	static float FireWeapon(UInventoryItemInstance* WeaponItem, double ShotTime);
+
+	/** Sets the given weapon's current heat. The weapon starts cooling down from the given heat as if it had just been
+	 * fired. */
+	UFUNCTION(BlueprintCallable, Category = "Heroes|Inventory|Weapons")
+	static void SetCurrentWeaponHeat(UInventoryItemInstance* WeaponItem, float NewHeat);
+
+	/** Returns the given weapon's heat at the time of its last shot. */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Heroes|Inventory|Weapons")
+	static float GetPreviousWeaponHeat(const UInventoryItemInstance* WeaponItem);
+
+	/** Sets the given weapon's heat at the time of its last shot. */
+	UFUNCTION(BlueprintCallable, Category = "Heroes|Inventory|Weapons")
+	static void SetPreviousWeaponHeat(UInventoryItemInstance* WeaponItem, float NewHeat);
 };
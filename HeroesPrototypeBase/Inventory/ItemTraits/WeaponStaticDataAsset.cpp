@@ -3,3 +3,108 @@
 
 #include "Inventory/ItemTraits/WeaponStaticDataAsset.h"
 
+#include "HeroesLogChannels.h"
+#include "Curves/CurveVector.h"
+#include "UObject/UObjectIterator.h"
+
+void FWeaponCurveLookupTable::Bake(const UCurveVector* Curve)
+{
+	bBaked = false;
+
+	if (!Curve)
+	{
+		return;
+	}
+
+	float MaxTime = 0.0f;
+	Curve->GetTimeRange(MinTime, MaxTime);
+
+	const float SampleInterval = (MaxTime - MinTime) / (NumSamples - 1);
+	InvSampleInterval = SampleInterval > UE_SMALL_NUMBER ? 1.0f / SampleInterval : 0.0f;
+
+	for (int32 i = 0; i < NumSamples; ++i)
+	{
+		const FVector Value = Curve->GetVectorValue(MinTime + (i * SampleInterval));
+		Samples[0][i] = Value.X;
+		Samples[1][i] = Value.Y;
+		Samples[2][i] = Value.Z;
+	}
+
+	bBaked = true;
+}
+
+float FWeaponCurveLookupTable::GetMaxError(const UCurveVector* Curve, int32 NumTestSamples) const
+{
+	if (!Curve || !bBaked || NumTestSamples < 2)
+	{
+		return 0.0f;
+	}
+
+	float CurveMinTime, CurveMaxTime;
+	Curve->GetTimeRange(CurveMinTime, CurveMaxTime);
+
+	float MaxError = 0.0f;
+	for (int32 i = 0; i < NumTestSamples; ++i)
+	{
+		const float Time = FMath::Lerp(CurveMinTime, CurveMaxTime, (float)i / (NumTestSamples - 1));
+		const FVector Error = (Sample(Time) - Curve->GetVectorValue(Time)).GetAbs();
+		MaxError = FMath::Max(MaxError, (float)Error.GetMax());
+	}
+
+	return MaxError;
+}
+
+void UWeaponStaticDataAsset::PostLoad()
+{
+	Super::PostLoad();
+
+	BakeCurveLookupTables();
+}
+
+#if WITH_EDITOR
+void UWeaponStaticDataAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	BakeCurveLookupTables();
+}
+#endif
+
+void UWeaponStaticDataAsset::BakeCurveLookupTables()
+{
+	// The curves' keys must be loaded before they can be baked.
+	for (UCurveVector* Curve : { RecoilCurve.Get(), SpreadCurve.Get(), MovementSpreadMultiplierCurve.Get() })
+	{
+		if (Curve)
+		{
+			Curve->ConditionalPostLoad();
+		}
+	}
+
+	RecoilLookupTable.Bake(RecoilCurve);
+	SpreadLookupTable.Bake(SpreadCurve);
+	MovementSpreadMultiplierLookupTable.Bake(MovementSpreadMultiplierCurve);
+}
+
+void UWeaponStaticDataAsset::LogCurveLookupTableErrors() const
+{
+	UE_LOG(LogHeroes, Log, TEXT("[%s] Recoil: %f, Spread: %f, Movement spread multiplier: %f"), *GetPathNameSafe(this), RecoilLookupTable.GetMaxError(RecoilCurve), SpreadLookupTable.GetMaxError(SpreadCurve), MovementSpreadMultiplierLookupTable.GetMaxError(MovementSpreadMultiplierCurve));
+}
+
+static FAutoConsoleCommand ValidateWeaponCurveLookupTablesCommand
+(
+	TEXT("Heroes.Weapons.ValidateCurveLookupTables"),
+	TEXT("Logs the largest error of every loaded weapon's baked curve lookup tables against the curves they were baked")
+	TEXT(" from."),
+	FConsoleCommandDelegate::CreateStatic([]()
+	{
+		for (TObjectIterator<UWeaponStaticDataAsset> It; It; ++It)
+		{
+			if (!It->HasAnyFlags(RF_ClassDefaultObject))
+			{
+				It->LogCurveLookupTableErrors();
+			}
+		}
+	}),
+	ECVF_Default
+);
@@ -4,8 +4,10 @@
 
 #include "CoreMinimal.h"
 #include "Engine/DataAsset.h"
+#include "Engine/EngineTypes.h"
 #include "WeaponStaticDataAsset.generated.h"
 
+class AHeroesGATA_Trace;
 class UCameraShakeBase;
 class UCurveVector;
 class UNiagaraSystem;
@@ -23,6 +25,61 @@ enum class EWeaponFireMode : uint8
 	Persistent = 5	UMETA(DisplayName = "Persistent")
 };
 
+/**
+ * A vector curve baked into a fixed-resolution lookup table. Each component's samples are stored contiguously, so
+ * sampling the table is two loads and a lerp per component instead of a key search on each of the curve's three
+ * float curves.
+ */
+struct HEROESPROTOTYPEBASE_API FWeaponCurveLookupTable
+{
+	/** The number of evenly-spaced samples baked from each curve, including both ends of its time range. */
+	static constexpr int32 NumSamples = 64;
+
+	/** Bakes the given curve into this table. Clears this table if the curve is null. */
+	void Bake(const UCurveVector* Curve);
+
+	/** Whether a curve has been baked into this table. */
+	bool IsBaked() const { return bBaked; }
+
+	/** Returns the baked curve's value at the given time, linearly interpolated between the nearest samples. Times
+	 * outside of the curve's time range are clamped. Returns zero if no curve has been baked. */
+	FVector Sample(float Time) const
+	{
+		if (!bBaked)
+		{
+			return FVector::ZeroVector;
+		}
+
+		const float Alpha = FMath::Clamp((Time - MinTime) * InvSampleInterval, 0.0f, (float)(NumSamples - 1));
+		const int32 Index = FMath::Min((int32)Alpha, NumSamples - 2);
+		const float Fraction = Alpha - Index;
+
+		return FVector
+		(
+			FMath::Lerp(Samples[0][Index], Samples[0][Index + 1], Fraction),
+			FMath::Lerp(Samples[1][Index], Samples[1][Index + 1], Fraction),
+			FMath::Lerp(Samples[2][Index], Samples[2][Index + 1], Fraction)
+		);
+	}
+
+	/** Returns the largest difference between any component of this table and the given curve, tested at the given
+	 * number of evenly-spaced times across the curve's time range. */
+	float GetMaxError(const UCurveVector* Curve, int32 NumTestSamples = 1024) const;
+
+private:
+
+	/** The samples of each component (X, Y, and Z) of the baked curve. */
+	alignas(16) float Samples[3][NumSamples];
+
+	/** The time of the first sample. */
+	float MinTime = 0.0f;
+
+	/** The inverse of the time between samples. Zero if the curve's time range is empty. */
+	float InvSampleInterval = 0.0f;
+
+	bool bBaked = false;
+};
+
 /**
  * 
  */
@@ -31,6 +88,45 @@ class HEROESPROTOTYPEBASE_API UWeaponStaticDataAsset : public UDataAsset
 {
 	GENERATED_BODY()
 
+public:
+
+	/** Bakes this weapon's curves into lookup tables once they've been loaded. */
+	virtual void PostLoad() override;
+
+#if WITH_EDITOR
+	/** Re-bakes this weapon's curves when they're edited. */
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	/** Bakes RecoilCurve, SpreadCurve, and MovementSpreadMultiplierCurve into their lookup tables. Must be called again
+	 * if any of the curves change. */
+	void BakeCurveLookupTables();
+
+	/** Returns this weapon's recoil at the given time, sampled from its baked recoil curve. */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Heroes|Inventory|Weapons")
+	FVector SampleRecoil(float Time) const { return RecoilLookupTable.Sample(Time); }
+
+	/** Returns this weapon's horizontal and vertical spread, in degrees, at the given heat, sampled from its baked
+	 * spread curve. */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Heroes|Inventory|Weapons")
+	FVector SampleSpread(float Heat) const { return SpreadLookupTable.Sample(Heat); }
+
+	/** Returns this weapon's spread multiplier at the given movement speed, sampled from its baked movement spread
+	 * multiplier curve. */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Heroes|Inventory|Weapons")
+	FVector SampleMovementSpreadMultiplier(float Speed) const { return MovementSpreadMultiplierLookupTable.Sample(Speed); }
+
+	/** Logs the largest error of each of this weapon's lookup tables against the curve it was baked from. */
+	void LogCurveLookupTableErrors() const;
+
+private:
+
+	FWeaponCurveLookupTable RecoilLookupTable;
+
+	FWeaponCurveLookupTable SpreadLookupTable;
+
+	FWeaponCurveLookupTable MovementSpreadMultiplierLookupTable;
+
 public:
 
 	// Gameplay.
@@ -54,6 +150,10 @@ public:
 	UPROPERTY(EditDefaultsOnly)
 	TObjectPtr<UCurveVector> MovementSpreadMultiplierCurve;
 
+	/** The number of pellets fired by each shot (e.g. for shotguns). Each pellet is traced with its own spread. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (ClampMin = 1, ClampMax = 64))
+	int32 PelletCount = 1;
+
 	/** Fire-rate, in rounds-per-minute. Only used for fully automatic and semi-automatic weapons. */
 	UPROPERTY(EditDefaultsOnly, meta = (EditCondition = "FireMode == 0 || FireMode == 1"), BlueprintReadOnly)
 	int32 FireRate;
@@ -68,7 +168,8 @@ public:
 
 	/** The amount of time without firing another shot at which the weapon's "heat" begins to cool down, resetting
 	 * the weapon's recoil and accuracy. */
-	float TimeBeforeHeadCooldown;
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float TimeBeforeHeatCooldown;
 
 	/** How quickly this weapon's heat scales from 0.0 to 1.0. Measured in heat-per-shot. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
@@ -85,6 +186,46 @@ public:
 
 
 
+	// Targeting.
+
+	/** The target actor used to trace this weapon's shots. Each ability system caches one target actor per weapon, so
+	 * it's spawned and configured once, when the weapon is equipped. Defaults to AHeroesGATA_Trace. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	TSubclassOf<AHeroesGATA_Trace> TargetActorClass;
+
+	/** The collision profile used to trace this weapon's shots. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	FCollisionProfileName TraceProfile;
+
+	/** If true, this weapon's shots pass through blocking hits. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	bool bIgnoreBlockingHits = false;
+
+	/** If true, this weapon's shots are traced by the server instead of the client. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	bool bProduceTargetDataOnServer = false;
+
+	/** If true, shots traced by the server are traced asynchronously. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (EditCondition = "bProduceTargetDataOnServer"))
+	bool bUseAsyncTraces = false;
+
+	/** The maximum range of this weapon's shots. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float MaxRange = 999999.0f;
+
+	/** If true, this weapon's shots only pass through as many surfaces as their penetration budget allows, and their
+	 * damage is attenuated by each surface they pass through. Otherwise, every hit returned by the trace is kept at
+	 * full damage. Surfaces can only be passed through if they overlap this weapon's trace profile. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	bool bLimitPenetration = false;
+
+	/** The total penetration cost that each shot can spend passing through surfaces (see UHeroesPhysicalMaterial).
+	 * Shots stop at the first surface they can't afford to pass through. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (EditCondition = "bLimitPenetration", ClampMin = 0))
+	float PenetrationBudget = 0.0f;
+
+
+
 	// VFX.
 
 	UPROPERTY(EditDefaultsOnly)
@@ -29,6 +29,9 @@ AHeroesGamePlayerStateBase::AHeroesGamePlayerStateBase(const FObjectInitializer&
 
 	// The ASC needs to be updated at a high frequency.
 	NetUpdateFrequency = 100.0f;
+
+	// Replicate sub-objects (e.g. inventory items) using their components' registered sub-object lists.
+	bReplicateUsingRegisteredSubObjectList = true;
 }
 
 void AHeroesGamePlayerStateBase::PostInitializeComponents()